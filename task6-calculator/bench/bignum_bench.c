@@ -0,0 +1,350 @@
+#include "bignum.h"
+#include "rpn.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Замеры BigNum и RPN на синтетических числах заданной длины (в разрядах).
+// Числа порождаются детерминированным генератором из --seed, так что прогоны
+// сравнимы между собой. Каждая операция повторяется, пока не наберётся
+// --min-time секунд (минимум один раз).
+
+#define BENCH_MAX_SIZES 64
+
+typedef enum { FORMAT_CSV, FORMAT_JSON } Format;
+
+typedef struct {
+    Format format;
+    double min_time;
+    uint64_t seed;
+    size_t sizes[BENCH_MAX_SIZES];
+    size_t size_count;
+    const char* ops;        // Список операций через запятую
+    bool first_row;
+} Bench;
+
+// Входные данные одного размера: два числа и их десятичная запись
+typedef struct {
+    size_t limbs;
+    BigNum* a;
+    BigNum* b;
+    char* a_text;
+    char* b_text;
+    char* expression;       // "a b * a + b -"
+} Inputs;
+
+typedef bool (*BenchFn)(const Inputs* in);
+
+static uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// Случайное число ровно из limbs разрядов (старший разряд не ноль)
+static BigNum* random_bignum(size_t limbs, uint64_t* state) {
+    BigNum* num = bignum_create();
+    if (!num) return NULL;
+
+    arraylist_resize(num->digits, limbs);
+    if (arraylist_size(num->digits) != limbs) {
+        bignum_free(num);
+        return NULL;
+    }
+    for (size_t i = 0; i < limbs; i++) {
+        num->digits->data[i] = (uint32_t)(xorshift64(state) >> 32);
+    }
+    num->digits->data[limbs - 1] |= 1u << 31;
+    return num;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool bench_parse(const Inputs* in) {
+    BigNum* num = bignum_from_string(in->a_text);
+    bignum_free(num);
+    return num != NULL;
+}
+
+static bool bench_print(const Inputs* in) {
+    char* text = bignum_to_string(in->a);
+    free(text);
+    return text != NULL;
+}
+
+static bool bench_add(const Inputs* in) {
+    BigNum* sum = bignum_add(in->a, in->b);
+    bignum_free(sum);
+    return sum != NULL;
+}
+
+static bool bench_subtract(const Inputs* in) {
+    BigNum* diff = bignum_subtract(in->a, in->b);
+    bignum_free(diff);
+    return diff != NULL;
+}
+
+static bool bench_multiply(const Inputs* in) {
+    BigNum* prod = bignum_multiply(in->a, in->b);
+    bignum_free(prod);
+    return prod != NULL;
+}
+
+static bool bench_gcd(const Inputs* in) {
+    BigNum* gcd = bignum_gcd(in->a, in->b);
+    bignum_free(gcd);
+    return gcd != NULL;
+}
+
+static bool bench_isqrt(const Inputs* in) {
+    BigNum* root = bignum_isqrt(in->a);
+    bignum_free(root);
+    return root != NULL;
+}
+
+static bool bench_rpn(const Inputs* in) {
+    RPNResult result = rpn_evaluate(in->expression);
+    bool ok = result.error == RPN_OK;
+    rpn_result_free(&result);
+    return ok;
+}
+
+static const struct {
+    const char* name;
+    BenchFn fn;
+} bench_ops[] = {
+    { "parse", bench_parse },
+    { "print", bench_print },
+    { "add", bench_add },
+    { "sub", bench_subtract },
+    { "mul", bench_multiply },
+    { "gcd", bench_gcd },
+    { "sqrt", bench_isqrt },
+    { "rpn", bench_rpn },
+};
+
+#define BENCH_OP_COUNT (sizeof(bench_ops) / sizeof(bench_ops[0]))
+
+static bool op_selected(const char* ops, const char* name) {
+    size_t len = strlen(name);
+    for (const char* p = ops; *p;) {
+        const char* comma = strchr(p, ',');
+        size_t item = comma ? (size_t)(comma - p) : strlen(p);
+        if (item == len && strncmp(p, name, len) == 0) return true;
+        if (!comma) break;
+        p = comma + 1;
+    }
+    return false;
+}
+
+// Каждый элемент списка — известная операция
+static bool ops_valid(const char* ops) {
+    for (const char* p = ops;;) {
+        const char* comma = strchr(p, ',');
+        size_t item = comma ? (size_t)(comma - p) : strlen(p);
+        bool known = false;
+        for (size_t i = 0; i < BENCH_OP_COUNT && !known; i++) {
+            known = strlen(bench_ops[i].name) == item && strncmp(p, bench_ops[i].name, item) == 0;
+        }
+        if (!known) return false;
+        if (!comma) return true;
+        p = comma + 1;
+    }
+}
+
+static void inputs_free(Inputs* in) {
+    bignum_free(in->a);
+    bignum_free(in->b);
+    free(in->a_text);
+    free(in->b_text);
+    free(in->expression);
+}
+
+static bool inputs_init(Inputs* in, size_t limbs, uint64_t seed) {
+    memset(in, 0, sizeof(*in));
+    in->limbs = limbs;
+
+    // Свой генератор на каждый размер: входы не зависят от набора размеров
+    uint64_t state = seed ^ (limbs * 0x9E3779B97F4A7C15ull);
+    if (state == 0) state = 1;
+
+    in->a = random_bignum(limbs, &state);
+    in->b = random_bignum(limbs, &state);
+    if (!in->a || !in->b) return false;
+
+    in->a_text = bignum_to_string(in->a);
+    in->b_text = bignum_to_string(in->b);
+    if (!in->a_text || !in->b_text) return false;
+
+    size_t a_len = strlen(in->a_text);
+    size_t b_len = strlen(in->b_text);
+    size_t size = 2 * (a_len + b_len) + 16;
+    in->expression = (char*)malloc(size);
+    if (!in->expression) return false;
+    snprintf(in->expression, size, "%s %s * %s + %s -", in->a_text, in->b_text, in->a_text,
+             in->b_text);
+    return true;
+}
+
+static void report(Bench* bench, const char* op, size_t limbs, size_t iterations,
+                   double seconds) {
+    double ns = seconds * 1e9 / iterations;
+    if (bench->format == FORMAT_CSV) {
+        if (bench->first_row) {
+            printf("op,limbs,iterations,seconds,ns_per_op\n");
+        }
+        printf("%s,%zu,%zu,%.6f,%.1f\n", op, limbs, iterations, seconds, ns);
+    } else {
+        printf("%s\n  {\"op\": \"%s\", \"limbs\": %zu, \"iterations\": %zu, "
+               "\"seconds\": %.6f, \"ns_per_op\": %.1f}",
+               bench->first_row ? "[" : ",", op, limbs, iterations, seconds, ns);
+    }
+    bench->first_row = false;
+    fflush(stdout);
+}
+
+static bool run_size(Bench* bench, size_t limbs) {
+    Inputs in;
+    if (!inputs_init(&in, limbs, bench->seed)) {
+        inputs_free(&in);
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < BENCH_OP_COUNT && ok; i++) {
+        if (!op_selected(bench->ops, bench_ops[i].name)) continue;
+
+        size_t iterations = 0;
+        double start = now();
+        double elapsed;
+        do {
+            ok = bench_ops[i].fn(&in);
+            iterations++;
+            elapsed = now() - start;
+        } while (ok && elapsed < bench->min_time);
+
+        if (ok) {
+            report(bench, bench_ops[i].name, limbs, iterations, elapsed);
+        }
+    }
+
+    inputs_free(&in);
+    return ok;
+}
+
+// Список размеров через запятую
+static bool parse_sizes(Bench* bench, const char* text) {
+    bench->size_count = 0;
+    while (*text) {
+        char* end;
+        unsigned long long size = strtoull(text, &end, 10);
+        if (end == text || size == 0 || bench->size_count == BENCH_MAX_SIZES) return false;
+        bench->sizes[bench->size_count++] = (size_t)size;
+        if (*end == ',') end++;
+        else if (*end) return false;
+        text = end;
+    }
+    return bench->size_count > 0;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--format csv|json] [--sizes N,N,...] [--max-limbs N] [--ops LIST]\n"
+            "          [--min-time SEC] [--seed N] [--threads N]\n"
+            "          [--karatsuba N] [--toom3 N] [--ntt N] [--parallel N]\n"
+            "Operations: parse,print,add,sub,mul,rpn (default), gcd,sqrt\n",
+            program);
+}
+
+int main(int argc, char** argv) {
+    Bench bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.format = FORMAT_CSV;
+    bench.min_time = 0.2;
+    bench.seed = 1;
+    bench.ops = "parse,print,add,sub,mul,rpn";
+    bench.first_row = true;
+
+    size_t max_limbs = (size_t)1 << 20;
+    bool explicit_sizes = false;
+    BigNumMulThresholds thresholds = bignum_get_mul_thresholds();
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        char* end = NULL;
+        bool ok = value != NULL;
+
+        if (ok && strcmp(arg, "--format") == 0) {
+            ok = strcmp(value, "csv") == 0 || strcmp(value, "json") == 0;
+            bench.format = strcmp(value, "json") == 0 ? FORMAT_JSON : FORMAT_CSV;
+        } else if (ok && strcmp(arg, "--sizes") == 0) {
+            ok = parse_sizes(&bench, value);
+            explicit_sizes = true;
+        } else if (ok && strcmp(arg, "--max-limbs") == 0) {
+            max_limbs = strtoull(value, &end, 10);
+            ok = *end == '\0' && max_limbs > 0;
+        } else if (ok && strcmp(arg, "--ops") == 0) {
+            bench.ops = value;
+            ok = ops_valid(value);
+        } else if (ok && strcmp(arg, "--min-time") == 0) {
+            bench.min_time = strtod(value, &end);
+            ok = *end == '\0' && bench.min_time >= 0;
+        } else if (ok && strcmp(arg, "--seed") == 0) {
+            bench.seed = strtoull(value, &end, 10);
+            ok = *end == '\0';
+        } else if (ok && strcmp(arg, "--threads") == 0) {
+            unsigned long threads = strtoul(value, &end, 10);
+            ok = *end == '\0' && threads > 0;
+            if (ok) bignum_set_threads(threads);
+        } else if (ok && strcmp(arg, "--karatsuba") == 0) {
+            thresholds.karatsuba = strtoull(value, &end, 10);
+            ok = *end == '\0';
+        } else if (ok && strcmp(arg, "--toom3") == 0) {
+            thresholds.toom3 = strtoull(value, &end, 10);
+            ok = *end == '\0';
+        } else if (ok && strcmp(arg, "--ntt") == 0) {
+            thresholds.ntt = strtoull(value, &end, 10);
+            ok = *end == '\0';
+        } else if (ok && strcmp(arg, "--parallel") == 0) {
+            thresholds.parallel = strtoull(value, &end, 10);
+            ok = *end == '\0';
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    bignum_set_mul_thresholds(&thresholds);
+
+    // По умолчанию — степени четвёрки от 1 до max_limbs
+    if (!explicit_sizes) {
+        for (size_t size = 1; size <= max_limbs && bench.size_count < BENCH_MAX_SIZES; size *= 4) {
+            bench.sizes[bench.size_count++] = size;
+        }
+    }
+
+    for (size_t i = 0; i < bench.size_count; i++) {
+        if (!run_size(&bench, bench.sizes[i])) {
+            fprintf(stderr, "Benchmark failed at %zu limbs\n", bench.sizes[i]);
+            return 1;
+        }
+    }
+
+    if (bench.format == FORMAT_JSON) {
+        printf("%s\n", bench.first_row ? "[]" : "\n]");
+    }
+    return 0;
+}
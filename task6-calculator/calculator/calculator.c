@@ -2,46 +2,177 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-#define MAX_INPUT_SIZE 100000
+static double seconds_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Статистика вычисления в stderr, время в миллисекундах
+static void print_stats(const RPNStats* stats, double print_seconds) {
+    fprintf(stderr, "tokens: %zu (numbers: %zu, operators: %zu)\n", stats->tokens,
+            stats->numbers, stats->tokens - stats->numbers);
+    fprintf(stderr, "parse: %zu limbs, %.3f ms\n", stats->number_limbs,
+            stats->parse_seconds * 1e3);
+    for (size_t i = 0; i < RPN_STATS_OPERATOR_COUNT; i++) {
+        const RPNOperatorStats* op = &stats->operators[i];
+        if (op->calls > 0) {
+            fprintf(stderr, "op '%c': %zu calls, %zu limbs, %.3f ms\n",
+                    RPN_STATS_OPERATORS[i], op->calls, op->limbs, op->seconds * 1e3);
+        }
+    }
+    fprintf(stderr, "peak stack depth: %zu\n", stats->peak_depth);
+    fprintf(stderr, "allocations: %zu (%zu bytes)\n", stats->allocations,
+            stats->allocated_bytes);
+    fprintf(stderr, "evaluate: %.3f ms\n", stats->total_seconds * 1e3);
+    fprintf(stderr, "print: %.3f ms\n", print_seconds * 1e3);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--threads N] [--cache MB] [--stats] [--mod M] [--hex]\n"
+                    "       %s --batch [--threads N]\n", program, program);
+}
+
+int main(int argc, char** argv) {
+    bool batch = false;
+    long threads = 0;
+    long cache_mb = 0;
+    bool stats_enabled = false;
+    bool hex = false;
+    const char* modulus_text = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats_enabled = true;
+        } else if (strcmp(argv[i], "--hex") == 0) {
+            hex = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            char* end;
+            threads = strtol(argv[++i], &end, 10);
+            if (*end || threads < 1) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            char* end;
+            cache_mb = strtol(argv[++i], &end, 10);
+            if (*end || cache_mb < 1) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--mod") == 0 && i + 1 < argc) {
+            modulus_text = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Кэш, статистика, модуль и вывод в hex относятся к одному выражению
+    // и в пакетном режиме недоступны
+    if (batch) {
+        const char* conflict = cache_mb > 0 ? "--cache" : stats_enabled ? "--stats"
+                             : modulus_text ? "--mod" : hex ? "--hex" : NULL;
+        if (conflict) {
+            fprintf(stderr, "%s cannot be combined with --batch\n", conflict);
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (batch) {
+        // По строке на выражение; по умолчанию заняты все ядра
+        if (threads == 0) {
+            threads = sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        size_t errors = 0;
+        if (!rpn_evaluate_batch(stdin, stdout, threads > 0 ? (size_t)threads : 1, &errors)) {
+            fprintf(stderr, "Batch evaluation failed\n");
+            return 2;
+        }
+        return errors ? 1 : 0;
+    }
 
-int main(void) {
-    char* input = (char*)malloc(MAX_INPUT_SIZE);
-    if (!input) {
+    // Модуль: число больше нуля (можно в записи 0x или 0b)
+    BigNum* modulus = NULL;
+    if (modulus_text) {
+        modulus = bignum_from_string(modulus_text);
+        if (!modulus || modulus->is_negative || bignum_is_zero(modulus)) {
+            bignum_free(modulus);
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Потоки для умножения очень больших чисел
+    if (threads > 1) {
+        bignum_set_threads((size_t)threads);
+    }
+
+    // Кэш повторяющихся дорогих подвыражений
+    RPNCache* cache = NULL;
+    if (cache_mb > 0 && !(cache = rpn_cache_create((size_t)cache_mb << 20))) {
+        bignum_free(modulus);
         fprintf(stderr, "Memory allocation failed\n");
         return 2;
     }
 
-    if (!fgets(input, MAX_INPUT_SIZE, stdin)) {
-        free(input);
-        fprintf(stderr, "Failed to read input\n");
+    RPNStream* stream = rpn_stream_create();
+    if (!stream) {
+        rpn_cache_free(cache);
+        bignum_free(modulus);
+        fprintf(stderr, "Memory allocation failed\n");
         return 2;
     }
-  
-    size_t len = strlen(input);
-    if (len > 0 && input[len - 1] == '\n') {
-        input[len - 1] = '\0';
+
+    RPNStats stats;
+    memset(&stats, 0, sizeof(stats));
+    rpn_stream_set_cache(stream, cache);
+    if (stats_enabled) {
+        rpn_stream_set_stats(stream, &stats);
+    }
+    if (modulus) {
+        rpn_stream_set_modulus(stream, modulus);
+        bignum_free(modulus);
     }
-  
-    RPNResult result = rpn_evaluate(input);
-    free(input);
+
+    // Выражение читается из stdin целиком, без ограничения длины. Если модуль
+    // не удалось подготовить, ошибку вернёт rpn_stream_finish
+    rpn_stream_feed_file(stream, stdin);
+    RPNResult result = rpn_stream_finish(stream);
+    rpn_stream_free(stream);
+    rpn_cache_free(cache);
 
     if (result.error != RPN_OK) {
         fprintf(stderr, "%s\n", result.error_message);
+        if (stats_enabled) {
+            print_stats(&stats, 0);
+        }
         rpn_result_free(&result);
         return 1;
     }
 
-    char* result_str = bignum_to_string(result.result);
-    if (!result_str) {
-        rpn_result_free(&result);
-        fprintf(stderr, "Memory allocation failed\n");
+    // Число печатается по мере перевода, без строки на всю запись;
+    // шестнадцатеричная запись перевода между основаниями не требует
+    double print_start = seconds_now();
+    bool printed = (hex ? bignum_write_hex(stdout, result.result)
+                        : bignum_write(stdout, result.result)) &&
+                   putchar('\n') != EOF && fflush(stdout) == 0;
+    double print_seconds = seconds_now() - print_start;
+    rpn_result_free(&result);
+    if (!printed) {
+        fprintf(stderr, ferror(stdout) ? "Write error\n" : "Memory allocation failed\n");
         return 2;
     }
 
-    printf("%s\n", result_str);
-    free(result_str);
-    rpn_result_free(&result);
+    if (stats_enabled) {
+        print_stats(&stats, print_seconds);
+    }
 
     return 0;
 }
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+// Арена: память выделяется последовательно из крупных блоков и освобождается
+// вся сразу через arena_reset. Отдельные выделения можно вернуть через arena_free:
+// куски того же класса размера выдаются повторно, а сами блоки не уменьшаются.
+typedef struct Arena Arena;
+
+Arena* arena_create(void);
+void arena_destroy(Arena* arena);
+
+// Выделение size байт с выравниванием max_align_t. NULL при нехватке памяти.
+void* arena_alloc(Arena* arena, size_t size);
+
+// Увеличение выделения ptr (old_size байт) до new_size. Последнее выделение
+// растёт на месте, иначе данные копируются в новый кусок арены, а старый освобождается.
+void* arena_realloc(Arena* arena, void* ptr, size_t old_size, size_t new_size);
+
+// Возврат выделения ptr размером size (тем, что запрашивался) для повторного использования.
+// Меньший size допустим: кусок просто попадёт в меньший класс.
+void arena_free(Arena* arena, void* ptr, size_t size);
+
+// Освобождает всё выделенное разом. Блоки остаются за ареной (сливаются в один),
+// так что следующее вычисление того же размера обходится без malloc.
+void arena_reset(Arena* arena);
+
+// Сколько байт сейчас выделено из арены
+size_t arena_used(const Arena* arena);
@@ -1,17 +1,31 @@
 #pragma once
 
+#include "arena.h"
 #include <stdint.h>
 #include <stddef.h>
 
+// Сколько элементов хранится прямо в структуре, без отдельного буфера в куче
+#define ARRAYLIST_INLINE_CAPACITY 8
+
 typedef struct {
-    uint32_t* data;
+    uint32_t* data;     // inline_data или буфер в куче после роста
     size_t size;
     size_t capacity;
+    Arena* arena;       // Если не NULL, внешний буфер берётся из арены и возвращается в неё
+    uint32_t inline_data[ARRAYLIST_INLINE_CAPACITY];
 } ArrayList;
 
 ArrayList* arraylist_create(void);
 void arraylist_free(ArrayList* list);
 
+// Для списков, встроенных в другие структуры или лежащих на стеке.
+// Такой список нельзя копировать присваиванием: data может указывать внутрь него.
+void arraylist_init(ArrayList* list);
+void arraylist_init_in(ArrayList* list, Arena* arena);
+void arraylist_destroy(ArrayList* list);
+// Обмен содержимым; арена переходит вместе с буфером
+void arraylist_swap(ArrayList* a, ArrayList* b);
+
 void arraylist_push(ArrayList* list, uint32_t value);
 uint32_t arraylist_pop(ArrayList* list);
 uint32_t arraylist_get(const ArrayList* list, size_t index);
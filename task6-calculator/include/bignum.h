@@ -2,14 +2,24 @@
 
 #include "arraylist.h"
 #include <stdbool.h>
+#include <stdio.h>
 
-// Основание системы счисления 10^9
-// Каждый разряд от 0 до 999,999,999
-#define BASE 1000000000
+// Основание системы счисления 2^32: разряд — полное машинное слово,
+// переносы и деления на BASE сводятся к сдвигам. Десятичная запись
+// появляется только при разборе и печати.
+#define BASE ((uint64_t)1 << 32)
+
+// Наибольшая длина результата (в разрядах, 512 МБ), за которую берутся
+// операции, способные по короткой записи потребовать непомерную память и
+// время (степень, произведение диапазона): более длинный результат сразу
+// отклоняется, а не считается часами до нехватки памяти
+#define BIGNUM_MAX_LIMBS ((size_t)1 << 27)
 
 typedef struct {
     ArrayList* digits;  // Разряды числа (младшие разряды в начале)
     bool is_negative;   // Знак числа
+    ArrayList storage;  // Место под разряды: digits указывает сюда, короткие числа
+                        // целиком помещаются во встроенный буфер без аллокаций
 } BigNum;
 
 BigNum* bignum_create(void);
@@ -17,8 +27,32 @@ BigNum* bignum_from_string(const char* str);
 BigNum* bignum_from_int(int64_t value);
 void bignum_free(BigNum* num);
 
+// Число, целиком (структура и разряды) живущее в арене: bignum_free возвращает его
+// память арене для повторного использования, остальное уходит с arena_reset.
+// Вынести значение из арены можно через bignum_clone, копия всегда создаётся в куче.
+BigNum* bignum_create_in(Arena* arena);
+BigNum* bignum_from_string_in(const char* str, Arena* arena);
+
+// Разбор ровно len символов str без завершающего нуля: число читается прямо
+// из буфера ввода, без копирования лексемы. Кроме десятичной записи понимает
+// шестнадцатеричную с префиксом 0x и двоичную с 0b (после знака): она
+// раскладывается по разрядам за линейное время.
+BigNum* bignum_from_chars(const char* str, size_t len);
+BigNum* bignum_from_chars_in(const char* str, size_t len, Arena* arena);
+
 char* bignum_to_string(const BigNum* num);
 
+// Десятичная запись num в file без построения всей строки и массива групп:
+// цифры выдаются по мере перевода кусками по 1 МБ. Сам перевод (деление
+// пополам с быстрым умножением) всё равно берёт рабочую память, в несколько
+// раз превышающую длину num в байтах, а степени 10 до половины длины числа
+// остаются в кэше. false при нехватке памяти или ошибке записи.
+bool bignum_write(FILE* file, const BigNum* num);
+
+// Шестнадцатеричная запись с префиксом 0x (строчные цифры): разряды просто
+// режутся по 4 бита, за линейное время
+bool bignum_write_hex(FILE* file, const BigNum* num);
+
 int bignum_compare(const BigNum* a, const BigNum* b);
 int bignum_compare_abs(const BigNum* a, const BigNum* b);
 
@@ -26,6 +60,107 @@ BigNum* bignum_add(const BigNum* a, const BigNum* b);
 BigNum* bignum_subtract(const BigNum* a, const BigNum* b);
 BigNum* bignum_multiply(const BigNum* a, const BigNum* b);
 
+// То же с записью результата в существующий dst (его буфер разрядов переиспользуется).
+// dst может совпадать с a и/или b. Возвращают false при нехватке памяти.
+bool bignum_add_into(BigNum* dst, const BigNum* a, const BigNum* b);
+bool bignum_subtract_into(BigNum* dst, const BigNum* a, const BigNum* b);
+bool bignum_multiply_into(BigNum* dst, const BigNum* a, const BigNum* b);
+
+// Квадрат числа: попарные произведения разрядов считаются один раз,
+// примерно вдвое меньше работы, чем умножение разных чисел той же длины
+BigNum* bignum_square(const BigNum* a);
+bool bignum_square_into(BigNum* dst, const BigNum* a);
+
+// base^exponent бинарным возведением в степень (0^0 = 1). dst может совпадать с base.
+// Возвращает false при нехватке памяти или результате длиннее BIGNUM_MAX_LIMBS.
+BigNum* bignum_pow(const BigNum* base, uint64_t exponent);
+bool bignum_pow_into(BigNum* dst, const BigNum* base, uint64_t exponent);
+// Оценка сверху длины base^exponent в разрядах (SIZE_MAX, если не помещается в size_t)
+size_t bignum_pow_size(const BigNum* base, uint64_t exponent);
+
+// Деление с остатком: частное округляется к нулю, остаток имеет знак делимого.
+// quotient и remainder могут быть NULL. Возвращает false при делении на ноль
+// или нехватке памяти.
+bool bignum_divmod(const BigNum* a, const BigNum* b, BigNum** quotient, BigNum** remainder);
+BigNum* bignum_divide(const BigNum* a, const BigNum* b);
+BigNum* bignum_mod(const BigNum* a, const BigNum* b);
+// То же с записью в существующие числа. quotient и remainder могут быть NULL
+// или совпадать с a и b, но не друг с другом.
+bool bignum_divmod_into(BigNum* quotient, BigNum* remainder, const BigNum* a, const BigNum* b);
+
+// Пороги выбора алгоритма умножения (в разрядах меньшего множителя):
+// меньше karatsuba — школьное, меньше toom3 — Карацуба, меньше ntt — Тоом-3,
+// иначе NTT (теоретико-числовое преобразование). Начиная с parallel NTT
+// делится между потоками, если они включены bignum_set_threads. Сеттер
+// поднимает пороги до karatsuba <= toom3 <= ntt <= parallel.
+typedef struct {
+    size_t karatsuba;
+    size_t toom3;
+    size_t ntt;
+    size_t parallel;
+} BigNumMulThresholds;
+
+void bignum_set_mul_thresholds(const BigNumMulThresholds* thresholds);
+BigNumMulThresholds bignum_get_mul_thresholds(void);
+
+// Число потоков для умножения очень больших чисел, включая вызывающий
+// (по умолчанию 1 — без потоков). Меняется между вычислениями, не во время них.
+// Возвращает false, если пул потоков не удалось создать (остаётся один поток).
+bool bignum_set_threads(size_t threads);
+size_t bignum_get_threads(void);
+
+// Наибольший общий делитель модулей a и b (НОД(0, 0) = 0): алгоритм Лемера,
+// для длинных чисел — половинный НОД за O(M(n) log n). dst может совпадать
+// с a и b. false при нехватке памяти.
+BigNum* bignum_gcd(const BigNum* a, const BigNum* b);
+bool bignum_gcd_into(BigNum* dst, const BigNum* a, const BigNum* b);
+
+// Целая часть квадратного корня (итерация Ньютона с удвоением точности,
+// по стоимости — несколько умножений). dst может совпадать с a. false для
+// отрицательного a или при нехватке памяти.
+BigNum* bignum_isqrt(const BigNum* a);
+bool bignum_isqrt_into(BigNum* dst, const BigNum* a);
+
+// Произведение from·(from+1)·…·to сбалансированным деревом умножений (binary
+// splitting): дорогие умножения идут между числами близкой длины. Пустое
+// произведение (from > to) равно 1. n! — произведение 1..n. false при нехватке
+// памяти или результате длиннее BIGNUM_MAX_LIMBS.
+BigNum* bignum_product_range(uint64_t from, uint64_t to);
+bool bignum_product_range_into(BigNum* dst, uint64_t from, uint64_t to);
+// Оценка сверху длины произведения from..to в разрядах (SIZE_MAX, если не помещается)
+size_t bignum_product_range_size(uint64_t from, uint64_t to);
+BigNum* bignum_factorial(uint64_t n);
+bool bignum_factorial_into(BigNum* dst, uint64_t n);
+
+// Арифметика по модулю m > 0. Значения — вычеты из [0, m) во внутренней форме:
+// для нечётного m это форма Монтгомери (x·R mod m), где умножение обходится
+// без деления на m, для чётного — обычный вычет. В форму число переводит
+// bignum_mod_enter (любое, в том числе отрицательное), обратно —
+// bignum_mod_leave. Размер значений не превышает размера m. dst может
+// совпадать с операндами. Функции возвращают false при нехватке памяти.
+typedef struct BigNumModulus BigNumModulus;
+
+// NULL, если m <= 0 или не хватило памяти
+BigNumModulus* bignum_modulus_create(const BigNum* m);
+void bignum_modulus_free(BigNumModulus* mod);
+const BigNum* bignum_modulus_value(const BigNumModulus* mod);
+
+bool bignum_mod_enter(const BigNumModulus* mod, BigNum* dst, const BigNum* a);
+bool bignum_mod_leave(const BigNumModulus* mod, BigNum* dst, const BigNum* a);
+bool bignum_mod_add_into(const BigNumModulus* mod, BigNum* dst, const BigNum* a,
+                         const BigNum* b);
+bool bignum_mod_subtract_into(const BigNumModulus* mod, BigNum* dst, const BigNum* a,
+                              const BigNum* b);
+bool bignum_mod_multiply_into(const BigNumModulus* mod, BigNum* dst, const BigNum* a,
+                              const BigNum* b);
+// base^exponent; показатель — обычное неотрицательное число, не вычет
+bool bignum_mod_pow_into(const BigNumModulus* mod, BigNum* dst, const BigNum* base,
+                         const BigNum* exponent);
+
 BigNum* bignum_clone(const BigNum* num);
+// Копирует значение src в dst, переиспользуя буфер dst. false при нехватке памяти.
+bool bignum_assign(BigNum* dst, const BigNum* src);
 void bignum_normalize(BigNum* num);
 bool bignum_is_zero(const BigNum* num);
+// Значение в uint64_t; false, если число отрицательно или не помещается
+bool bignum_to_uint64(const BigNum* num, uint64_t* value);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "bignum.h"
+#include <stdio.h>
 
 // Коды ошибок
 typedef enum {
@@ -10,6 +11,11 @@ typedef enum {
     RPN_ERROR_MISSING_OP = 1,
     RPN_ERROR_INSUFFICIENT_OPERANDS = 1,
     RPN_ERROR_TOO_MANY_OPERANDS = 1,
+    RPN_ERROR_DIVISION_BY_ZERO = 1,
+    RPN_ERROR_NEGATIVE_EXPONENT = 1,
+    RPN_ERROR_NEGATIVE_ROOT = 1,
+    RPN_ERROR_NEGATIVE_FACTORIAL = 1,
+    RPN_ERROR_TOO_LARGE = 1,
     RPN_ERROR_MEMORY = 2
 } RPNError;
 
@@ -18,11 +24,128 @@ typedef struct {
     BigNum* result;
     RPNError error;
     char* error_message;
-    int error_position;
+    long long error_position;  // Смещение ошибки в тексте, -1 — без позиции
 } RPNResult;
 
-// Вычисление RPN выражения
+// Вычисление RPN выражения. Бинарные операторы: + - * / % ^, & — НОД модулей
+// операндов, : — произведение a·(a+1)·…·b (пустое при a > b равно 1); унарные:
+// ~ — целая часть квадратного корня, ! — факториал. Числа записываются
+// десятично или с префиксом 0x (шестнадцатеричные), 0b (двоичные).
 RPNResult rpn_evaluate(const char* expression);
 
+// То же, но вся промежуточная память (лексемы, стек, числа) берётся из arena
+// и возвращается одним arena_reset перед выходом. Результат выносится в кучу
+// и освобождается rpn_result_free, так что одну арену можно переиспользовать
+// для потока выражений без фрагментации кучи.
+RPNResult rpn_evaluate_in(const char* expression, Arena* arena);
+
+// Потоковое вычисление: выражение подаётся кусками любой длины, лексема может
+// быть разорвана между кусками. Память нужна только под стек операндов
+// и текущее число, а не под весь текст.
+typedef struct RPNStream RPNStream;
+
+RPNStream* rpn_stream_create(void);
+// false, если в уже поданном тексте найдена ошибка (её вернёт rpn_stream_finish)
+bool rpn_stream_feed(RPNStream* stream, const char* data, size_t size);
+// Завершает выражение; после этого поток остаётся только освободить
+RPNResult rpn_stream_finish(RPNStream* stream);
+void rpn_stream_free(RPNStream* stream);
+
+// Подача в поток всего файла до конца. Обычный файл отображается в память
+// (mmap), каналы и терминал читаются кусками. false при ошибке в тексте
+// (её вернёт rpn_stream_finish) или нехватке памяти.
+bool rpn_stream_feed_file(RPNStream* stream, FILE* file);
+
+// Вычисление выражения из файла до его конца
+RPNResult rpn_evaluate_file(FILE* file);
+
+// Операторы в порядке элементов RPNStats.operators
+#define RPN_STATS_OPERATORS "+-*/%^&~!:"
+#define RPN_STATS_OPERATOR_COUNT 10
+
+typedef struct {
+    size_t calls;
+    size_t limbs;           // Сумма длин операндов в разрядах
+    double seconds;
+} RPNOperatorStats;
+
+// Статистика вычисления: куда ушло время и память
+typedef struct {
+    size_t tokens;          // Чисел и операторов
+    size_t numbers;
+    size_t number_limbs;    // Разрядов в разобранных числах
+    double parse_seconds;   // Перевод чисел из десятичной записи
+    RPNOperatorStats operators[RPN_STATS_OPERATOR_COUNT];
+    size_t peak_depth;      // Наибольшая глубина стека
+    size_t allocations;     // Выделений из кучи в библиотеке
+    size_t allocated_bytes;
+    double total_seconds;   // Всё время внутри rpn_stream_feed/finish
+} RPNStats;
+
+// Включает сбор статистики потока в stats (NULL — выключает). Значения
+// прибавляются к уже лежащим в stats, обнулить её — забота вызывающего.
+// Учитываются выделения памяти только текущего потока выполнения.
+void rpn_stream_set_stats(RPNStream* stream, RPNStats* stats);
+
+// Кэш результатов дорогих операций (*, /, %, &, ~ над большими числами, ^, ! и :) по
+// значениям операндов: повторное подвыражение, например многократный квадрат
+// одной огромной константы, берётся из кэша. Занимает не больше max_bytes,
+// при переполнении вытесняются давно не использованные записи. Кэш можно
+// держать между вычислениями. Не потокобезопасен: по кэшу на поток.
+typedef struct RPNCache RPNCache;
+
+RPNCache* rpn_cache_create(size_t max_bytes);
+void rpn_cache_clear(RPNCache* cache);
+void rpn_cache_free(RPNCache* cache);
+// Любой из указателей может быть NULL
+void rpn_cache_stats(const RPNCache* cache, size_t* hits, size_t* misses, size_t* bytes);
+
+// Подключает кэш к потоку (NULL — отключает); поток кэш не освобождает
+void rpn_stream_set_cache(RPNStream* stream, RPNCache* cache);
+
+// Модульный режим: каждое число приводится по модулю m > 0, а + - * ^ дают
+// вычеты (умножение в форме Монтгомери), так что промежуточные значения
+// не длиннее модуля. Показатель степени — само число из текста (не вычет,
+// и может быть больше m); результат операции показателем быть не может,
+// как и отрицательное число. Операторы /, %, &, ~, ! и : в этом режиме — ошибка.
+// Вызывается до подачи текста; при неверном модуле или уже поданном тексте
+// возвращает false, ошибку вернёт rpn_stream_finish.
+bool rpn_stream_set_modulus(RPNStream* stream, const BigNum* modulus);
+RPNResult rpn_evaluate_mod(const char* expression, const BigNum* modulus);
+
+// rpn_evaluate и rpn_evaluate_file с кэшем (cache может быть NULL)
+RPNResult rpn_evaluate_cached(const char* expression, RPNCache* cache);
+RPNResult rpn_evaluate_file_cached(FILE* file, RPNCache* cache);
+
+// Пакетный режим: каждая строка in — отдельное выражение. Строки вычисляются
+// параллельно на threads потоках, ответы пишутся в out в порядке строк,
+// ошибки — строкой "error: <сообщение>". Пустые строки (и из одних пробелов)
+// пропускаются и ответа не получают. В errors (может быть NULL) — число
+// строк с ошибкой. Возвращает false при ошибке ввода-вывода или нехватке памяти.
+bool rpn_evaluate_batch(FILE* in, FILE* out, size_t threads, size_t* errors);
+
+// Скомпилированное выражение для многократного вычисления с разными входами.
+// Помимо чисел и операторов в тексте допускаются имена входов (слоты):
+// буква или '_', затем буквы, цифры и '_'. Текст разбирается и проверяется
+// один раз, постоянные подвыражения считаются при компиляции; rpn_run только
+// исполняет готовую программу. Одну программу можно исполнять из разных потоков.
+typedef struct RPNProgram RPNProgram;
+
+// NULL при ошибке; её описание (как у rpn_evaluate) пишется в *error, если он не NULL
+RPNProgram* rpn_compile(const char* expression, RPNResult* error);
+void rpn_program_free(RPNProgram* program);
+
+// Слоты нумеруются в порядке первого появления в тексте
+size_t rpn_program_slot_count(const RPNProgram* program);
+const char* rpn_program_slot_name(const RPNProgram* program, size_t index);
+// false, если слота с таким именем нет
+bool rpn_program_find_slot(const RPNProgram* program, const char* name, size_t* index);
+
+// inputs[i] — значение i-го слота (inputs может быть NULL, если слотов нет).
+// Входы не изменяются. Версия с ареной берёт из неё промежуточную память
+// и сбрасывает её перед выходом, как rpn_evaluate_in.
+RPNResult rpn_run(const RPNProgram* program, const BigNum* const* inputs);
+RPNResult rpn_run_in(const RPNProgram* program, const BigNum* const* inputs, Arena* arena);
+
 // Освобождение результата
 void rpn_result_free(RPNResult* result);
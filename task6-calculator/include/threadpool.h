@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+
+// Пул рабочих потоков для параллельных циклов. Потоки создаются один раз
+// и спят между заданиями.
+typedef struct ThreadPool ThreadPool;
+
+// threads — общее число исполнителей, включая вызывающий поток
+// (пул из threads - 1 рабочих). NULL при ошибке.
+ThreadPool* threadpool_create(size_t threads);
+void threadpool_destroy(ThreadPool* pool);
+size_t threadpool_size(const ThreadPool* pool);
+
+// Выполняет fn(ctx, i) для всех i из [0, count) и возвращается, когда все
+// вызовы завершены. Вызывающий поток тоже берёт индексы. Если пул занят
+// другим заданием (в том числе при вложенном вызове из fn), цикл
+// выполняется в вызывающем потоке последовательно. pool может быть NULL.
+void threadpool_for(ThreadPool* pool, void (*fn)(void* ctx, size_t index), void* ctx,
+                    size_t count);
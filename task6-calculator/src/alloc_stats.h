@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+
+// Учёт выделений памяти из кучи внутри библиотеки (блоки арен, разряды чисел,
+// рабочие буферы алгоритмов) для статистики вычислений. Счётчики у каждого
+// потока свои: разница до и после вычисления относится только к нему.
+typedef struct {
+    size_t count;
+    size_t bytes;
+} AllocStats;
+
+extern _Thread_local AllocStats alloc_stats;
+
+static inline void* counted_malloc(size_t size) {
+    alloc_stats.count++;
+    alloc_stats.bytes += size;
+    return malloc(size);
+}
+
+static inline void* counted_calloc(size_t count, size_t size) {
+    alloc_stats.count++;
+    alloc_stats.bytes += count * size;
+    return calloc(count, size);
+}
+
+static inline void* counted_realloc(void* ptr, size_t size) {
+    alloc_stats.count++;
+    alloc_stats.bytes += size;
+    return realloc(ptr, size);
+}
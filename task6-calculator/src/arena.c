@@ -0,0 +1,194 @@
+#include "arena.h"
+#include "alloc_stats.h"
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Размер первого блока; следующие блоки вдвое больше предыдущего
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+#define ARENA_ALIGN alignof(max_align_t)
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// Освобождённые куски хранятся по классам размера: до ARENA_SMALL_MAX байт
+// класс на каждый шаг выравнивания, дальше размеры округляются до степени двойки
+#define ARENA_SMALL_MAX 1024
+#define ARENA_SMALL_CLASSES (ARENA_SMALL_MAX / ARENA_ALIGN)
+#define ARENA_CLASSES (ARENA_SMALL_CLASSES + 64)
+
+_Thread_local AllocStats alloc_stats;
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;  // Предыдущий (заполненный) блок
+    size_t size;              // Вместимость области данных
+    size_t used;
+} ArenaBlock;
+
+struct Arena {
+    ArenaBlock* head;  // Текущий блок, из него идут выделения
+    void* last;        // Последнее выделение (для роста на месте)
+    void* free_lists[ARENA_CLASSES];  // Свободные куски; ссылка на следующий лежит в самом куске
+};
+
+#define BLOCK_HEADER ARENA_ROUND(sizeof(ArenaBlock))
+
+static inline unsigned char* block_data(ArenaBlock* block) {
+    return (unsigned char*)block + BLOCK_HEADER;
+}
+
+// Размер, который реально занимает выделение size байт. 0, если слишком велико.
+static size_t chunk_size(size_t size) {
+    if (size <= ARENA_SMALL_MAX) return ARENA_ROUND(size ? size : 1);
+    if (size > SIZE_MAX / 2 + 1) return 0;
+
+    size_t rounded = ARENA_SMALL_MAX * 2;
+    while (rounded < size) {
+        rounded *= 2;
+    }
+    return rounded;
+}
+
+static size_t chunk_class(size_t rounded) {
+    if (rounded <= ARENA_SMALL_MAX) return rounded / ARENA_ALIGN - 1;
+
+    size_t index = ARENA_SMALL_CLASSES;
+    while (rounded > ARENA_SMALL_MAX * 2) {
+        rounded /= 2;
+        index++;
+    }
+    return index;
+}
+
+static ArenaBlock* block_create(size_t size) {
+    if (size > SIZE_MAX - BLOCK_HEADER) return NULL;
+
+    ArenaBlock* block = (ArenaBlock*)counted_malloc(BLOCK_HEADER + size);
+    if (!block) return NULL;
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static void blocks_free(ArenaBlock* block) {
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+Arena* arena_create(void) {
+    Arena* arena = (Arena*)malloc(sizeof(Arena));
+    if (!arena) return NULL;
+
+    arena->head = NULL;
+    arena->last = NULL;
+    memset(arena->free_lists, 0, sizeof(arena->free_lists));
+    return arena;
+}
+
+void arena_destroy(Arena* arena) {
+    if (arena) {
+        blocks_free(arena->head);
+        free(arena);
+    }
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = chunk_size(size);
+    if (!size) return NULL;
+
+    void** list = &arena->free_lists[chunk_class(size)];
+    if (*list) {
+        void* ptr = *list;
+        *list = *(void**)ptr;
+        return ptr;
+    }
+
+    ArenaBlock* head = arena->head;
+    if (!head || head->size - head->used < size) {
+        size_t block_size = head ? head->size * 2 : ARENA_BLOCK_SIZE;
+        if (block_size < size) {
+            block_size = size;
+        }
+
+        ArenaBlock* block = block_create(block_size);
+        if (!block) return NULL;
+
+        block->next = head;
+        arena->head = head = block;
+    }
+
+    void* ptr = block_data(head) + head->used;
+    head->used += size;
+    arena->last = ptr;
+    return ptr;
+}
+
+void* arena_realloc(Arena* arena, void* ptr, size_t old_size, size_t new_size) {
+    if (new_size <= old_size) return ptr;
+
+    // Последнее выделение текущего блока можно просто продлить
+    ArenaBlock* head = arena->head;
+    size_t rounded = chunk_size(new_size);
+    if (ptr && ptr == arena->last && rounded) {
+        size_t offset = (size_t)((unsigned char*)ptr - block_data(head));
+        if (head->size - offset >= rounded) {
+            head->used = offset + rounded;
+            return ptr;
+        }
+    }
+
+    void* fresh = arena_alloc(arena, new_size);
+    if (fresh && ptr) {
+        memcpy(fresh, ptr, old_size);
+        arena_free(arena, ptr, old_size);
+    }
+    return fresh;
+}
+
+void arena_free(Arena* arena, void* ptr, size_t size) {
+    if (!ptr) return;
+
+    // Последнее выделение просто возвращается в текущий блок
+    if (ptr == arena->last) {
+        arena->head->used = (size_t)((unsigned char*)ptr - block_data(arena->head));
+        arena->last = NULL;
+        return;
+    }
+
+    void** list = &arena->free_lists[chunk_class(chunk_size(size))];
+    *(void**)ptr = *list;
+    *list = ptr;
+}
+
+void arena_reset(Arena* arena) {
+    ArenaBlock* head = arena->head;
+    arena->last = NULL;
+    memset(arena->free_lists, 0, sizeof(arena->free_lists));
+    if (!head) return;
+
+    if (head->next) {
+        // Несколько блоков сливаем в один общего размера
+        size_t total = 0;
+        for (ArenaBlock* block = head; block; block = block->next) {
+            total += block->size;
+        }
+        blocks_free(head);
+        arena->head = head = block_create(total);
+        if (!head) return;
+    }
+
+    head->used = 0;
+}
+
+size_t arena_used(const Arena* arena) {
+    size_t used = 0;
+    for (const ArenaBlock* block = arena->head; block; block = block->next) {
+        used += block->used;
+    }
+    return used;
+}
@@ -1,42 +1,88 @@
 #include "arraylist.h"
+#include "alloc_stats.h"
 #include <stdlib.h>
 #include <string.h>
 
-#define INITIAL_CAPACITY 8
-
 ArrayList* arraylist_create(void) {
     ArrayList* list = (ArrayList*)malloc(sizeof(ArrayList));
     if (!list) return NULL;
 
-    list->data = (uint32_t*)malloc(INITIAL_CAPACITY * sizeof(uint32_t));
-    if (!list->data) {
+    arraylist_init(list);
+    return list;
+}
+
+void arraylist_free(ArrayList* list) {
+    if (list) {
+        arraylist_destroy(list);
         free(list);
-        return NULL;
     }
+}
 
+void arraylist_init(ArrayList* list) {
+    arraylist_init_in(list, NULL);
+}
+
+void arraylist_init_in(ArrayList* list, Arena* arena) {
+    list->data = list->inline_data;
     list->size = 0;
-    list->capacity = INITIAL_CAPACITY;
-    return list;
+    list->capacity = ARRAYLIST_INLINE_CAPACITY;
+    list->arena = arena;
 }
 
-void arraylist_free(ArrayList* list) {
-    if (list) {
-        if (list->data) {
+void arraylist_destroy(ArrayList* list) {
+    if (list->data != list->inline_data) {
+        if (list->arena) {
+            arena_free(list->arena, list->data, list->capacity * sizeof(uint32_t));
+        } else {
             free(list->data);
         }
-        free(list);
     }
+    arraylist_init_in(list, list->arena);
 }
 
-static void arraylist_grow(ArrayList* list) {
-    size_t new_capacity = list->capacity * 2;
-    uint32_t* new_data = (uint32_t*)realloc(list->data, new_capacity * sizeof(uint32_t));
-    if (!new_data) return;
+void arraylist_swap(ArrayList* a, ArrayList* b) {
+    ArrayList tmp = *a;
+    *a = *b;
+    *b = tmp;
+
+    // Встроенные буферы переехали вместе со структурами — чиним указатели на них
+    if (a->data == b->inline_data) {
+        a->data = a->inline_data;
+    }
+    if (b->data == a->inline_data) {
+        b->data = b->inline_data;
+    }
+}
+
+// Перенос во внешний буфер вместимостью не меньше new_capacity
+static void arraylist_reserve(ArrayList* list, size_t new_capacity) {
+    uint32_t* new_data;
+    if (list->arena) {
+        // Старый буфер арена забирает себе для следующих выделений того же размера
+        void* old = list->data == list->inline_data ? NULL : list->data;
+        new_data = (uint32_t*)arena_realloc(list->arena, old, list->capacity * sizeof(uint32_t),
+                                            new_capacity * sizeof(uint32_t));
+        if (!new_data) return;
+        if (!old) {
+            memcpy(new_data, list->data, list->size * sizeof(uint32_t));
+        }
+    } else if (list->data == list->inline_data) {
+        new_data = (uint32_t*)counted_malloc(new_capacity * sizeof(uint32_t));
+        if (!new_data) return;
+        memcpy(new_data, list->data, list->size * sizeof(uint32_t));
+    } else {
+        new_data = (uint32_t*)counted_realloc(list->data, new_capacity * sizeof(uint32_t));
+        if (!new_data) return;
+    }
 
     list->data = new_data;
     list->capacity = new_capacity;
 }
 
+static void arraylist_grow(ArrayList* list) {
+    arraylist_reserve(list, list->capacity * 2);
+}
+
 void arraylist_push(ArrayList* list, uint32_t value) {
     if (list->size >= list->capacity) {
         arraylist_grow(list);
@@ -69,12 +115,12 @@ void arraylist_clear(ArrayList* list) {
 
 void arraylist_resize(ArrayList* list, size_t new_size) {
     if (new_size > list->capacity) {
-        while (list->capacity < new_size) {
-            list->capacity *= 2;
+        size_t new_capacity = list->capacity;
+        while (new_capacity < new_size) {
+            new_capacity *= 2;
         }
-        uint32_t* new_data = (uint32_t*)realloc(list->data, list->capacity * sizeof(uint32_t));
-        if (!new_data) return;
-        list->data = new_data;
+        arraylist_reserve(list, new_capacity);
+        if (list->capacity < new_size) return;
     }
 
     if (new_size > list->size) {
@@ -1,79 +1,162 @@
-#include "bignum.h"
+#include "bignum_internal.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <stdio.h>
+#include <stdint.h>
 
 BigNum* bignum_create(void) {
-    BigNum* num = (BigNum*)malloc(sizeof(BigNum));
-    if (!num) return NULL;
+    return bignum_create_in(NULL);
+}
 
-    num->digits = arraylist_create();
-    if (!num->digits) {
-        free(num);
-        return NULL;
-    }
+BigNum* bignum_create_in(Arena* arena) {
+    BigNum* num = arena ? (BigNum*)arena_alloc(arena, sizeof(BigNum))
+                        : (BigNum*)counted_malloc(sizeof(BigNum));
+    if (!num) return NULL;
 
+    arraylist_init_in(&num->storage, arena);
+    num->digits = &num->storage;
     num->is_negative = false;
     arraylist_push(num->digits, 0);
     return num;
 }
 
 void bignum_free(BigNum* num) {
-    if (num) {
-        if (num->digits) {
-            arraylist_free(num->digits);
-        }
+    if (!num) return;
+
+    Arena* arena = num->digits->arena;
+    arraylist_destroy(num->digits);
+    if (arena) {
+        arena_free(arena, num, sizeof(BigNum));
+    } else {
         free(num);
     }
 }
 
 BigNum* bignum_from_string(const char* str) {
-    if (!str || !*str) return NULL;
+    return bignum_from_string_in(str, NULL);
+}
 
-    BigNum* num = bignum_create();
+BigNum* bignum_from_string_in(const char* str, Arena* arena) {
+    return str ? bignum_from_chars_in(str, strlen(str), arena) : NULL;
+}
+
+static void free_groups(uint32_t* groups, const uint32_t* local, size_t count, Arena* arena) {
+    if (groups == local) return;
+    if (arena) {
+        arena_free(arena, groups, count * sizeof(uint32_t));
+    } else {
+        free(groups);
+    }
+}
+
+BigNum* bignum_from_chars(const char* str, size_t len) {
+    return bignum_from_chars_in(str, len, NULL);
+}
+
+// Значение цифры c в шестнадцатеричной записи, 16 — не цифра
+static unsigned int hex_digit_value(char c) {
+    if (c >= '0' && c <= '9') return (unsigned int)(c - '0');
+    if (c >= 'a' && c <= 'f') return (unsigned int)(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F') return (unsigned int)(c - 'A' + 10);
+    return 16;
+}
+
+// Модуль из len цифр по bits бит (1 — двоичная запись, 4 — шестнадцатеричная):
+// цифры раскладываются по разрядам сдвигами, без перевода между основаниями.
+// 32 делится на bits, поэтому цифра никогда не попадает на границу разрядов.
+static bool set_power2_digits(BigNum* num, const char* str, size_t len, unsigned int bits) {
+    if (len == 0) return false;
+
+    size_t count = (len - 1) / (32 / bits) + 1;
+    arraylist_resize(num->digits, count);
+    if (arraylist_size(num->digits) != count) return false;
+
+    uint32_t* d = num->digits->data;
+    for (size_t i = 0; i < len; i++) {
+        unsigned int value = hex_digit_value(str[len - 1 - i]);
+        if (value >> bits) return false;
+        size_t shift = i * bits;
+        d[shift / 32] |= (uint32_t)value << (shift % 32);
+    }
+
+    bignum_normalize(num);
+    return true;
+}
+
+BigNum* bignum_from_chars_in(const char* str, size_t len, Arena* arena) {
+    if (!str || len == 0) return NULL;
+
+    BigNum* num = bignum_create_in(arena);
     if (!num) return NULL;
 
     arraylist_clear(num->digits);
 
     // Проверка знака
-    size_t start = 0;
+    const char* end = str + len;
     if (str[0] == '-') {
         num->is_negative = true;
-        start = 1;
+        str++;
     }
 
-    // Пропуск ведущих нулей
-    while (str[start] == '0' && str[start + 1] != '\0') {
-        start++;
+    // Префиксы 0x и 0b: шестнадцатеричная и двоичная запись
+    if (end - str > 1 && str[0] == '0' &&
+        (str[1] == 'x' || str[1] == 'X' || str[1] == 'b' || str[1] == 'B')) {
+        unsigned int bits = str[1] == 'x' || str[1] == 'X' ? 4 : 1;
+        if (!set_power2_digits(num, str + 2, end - str - 2, bits)) {
+            bignum_free(num);
+            return NULL;
+        }
+        return num;
+    }
+
+    // Пропуск ведущих нулей (перед цифрой: "00x1" — ошибка, а не ноль)
+    while (end - str > 1 && str[0] == '0' && isdigit((unsigned char)str[1])) {
+        str++;
     }
 
-    size_t len = strlen(str + start);
-    if (len == 0 || !isdigit((unsigned char)str[start])) {
+    len = end - str;
+    if (len == 0 || !isdigit((unsigned char)*str)) {
         arraylist_push(num->digits, 0);
         num->is_negative = false;
         return num;
     }
 
-    // Парсим число по 9 цифр (BASE = 10^9)
-    const char* p = str + start + len;
-    while (p > str + start) {
-        uint32_t digit = 0;
-        uint32_t multiplier = 1;
-        int count = 0;
+    // Разбираем цифры группами по 9 (10^9) слева направо за один проход,
+    // старшая группа может быть короче; затем переводим группы в двоичный вид.
+    // Группы короткого числа помещаются в буфер на стеке.
+    size_t count = (len + DECIMAL_GROUP_DIGITS - 1) / DECIMAL_GROUP_DIGITS;
+    uint32_t local[16];
+    uint32_t* groups = count <= 16 ? local
+                     : arena ? (uint32_t*)arena_alloc(arena, count * sizeof(uint32_t))
+                             : (uint32_t*)counted_malloc(count * sizeof(uint32_t));
+    if (!groups) {
+        bignum_free(num);
+        return NULL;
+    }
 
-        while (count < 9 && p > str + start) {
-            p--;
-            if (!isdigit((unsigned char)*p)) {
+    const char* p = str;
+    size_t group_len = len - (count - 1) * DECIMAL_GROUP_DIGITS;
+    for (size_t i = count; i > 0; i--) {
+        uint32_t group = 0;
+        for (size_t k = 0; k < group_len; k++) {
+            unsigned int c = (unsigned char)*p++ - '0';
+            if (c > 9) {
+                free_groups(groups, local, count, arena);
                 bignum_free(num);
                 return NULL;
             }
-            digit += (*p - '0') * multiplier;
-            multiplier *= 10;
-            count++;
+            group = group * 10 + c;
         }
 
-        arraylist_push(num->digits, digit);
+        groups[i - 1] = group;
+        group_len = DECIMAL_GROUP_DIGITS;
+    }
+
+    bool ok = bignum_set_decimal_groups(num, groups, count);
+    free_groups(groups, local, count, arena);
+    if (!ok) {
+        bignum_free(num);
+        return NULL;
     }
 
     bignum_normalize(num);
@@ -104,17 +187,92 @@ BigNum* bignum_from_int(int64_t value) {
     return num;
 }
 
+BigNum* bignum_from_limbs(const uint32_t* limbs, size_t count) {
+    BigNum* num = bignum_create();
+    if (!num) return NULL;
+
+    if (count > 0) {
+        arraylist_resize(num->digits, count);
+        if (arraylist_size(num->digits) != count) {
+            bignum_free(num);
+            return NULL;
+        }
+        memcpy(num->digits->data, limbs, count * sizeof(uint32_t));
+        bignum_normalize(num);
+    }
+
+    return num;
+}
+
+uint32_t bignum_div_small(BigNum* num, uint32_t divisor) {
+    uint64_t rem = 0;
+    for (size_t i = arraylist_size(num->digits); i > 0; i--) {
+        uint64_t cur = num->digits->data[i - 1] + rem * BASE;
+        num->digits->data[i - 1] = (uint32_t)(cur / divisor);
+        rem = cur % divisor;
+    }
+
+    bignum_normalize(num);
+    return (uint32_t)rem;
+}
+
+bool bignum_replace(BigNum** dst, BigNum* fresh) {
+    bignum_free(*dst);
+    *dst = fresh;
+    return fresh != NULL;
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Ровно 9 цифр группы с ведущими нулями (замена sprintf("%09u"))
+void bignum_format_group(char* p, uint32_t value) {
+    for (int i = 7; i > 0; i -= 2) {
+        memcpy(p + i, digit_pairs + (value % 100) * 2, 2);
+        value /= 100;
+    }
+    p[0] = (char)('0' + value);
+}
+
+// Группа без ведущих нулей, возвращает число записанных цифр
+size_t bignum_format_group_head(char* p, uint32_t value) {
+    char buf[9];
+    bignum_format_group(buf, value);
+
+    size_t skip = 0;
+    while (skip < 8 && buf[skip] == '0') {
+        skip++;
+    }
+    memcpy(p, buf + skip, 9 - skip);
+    return 9 - skip;
+}
+
 char* bignum_to_string(const BigNum* num) {
     if (!num || arraylist_size(num->digits) == 0) {
-        char* result = (char*)malloc(2);
+        char* result = (char*)counted_malloc(2);
         strcpy(result, "0");
         return result;
     }
 
-    // Оценка размера: каждый разряд = до 9 цифр + знак + \0
-    size_t max_size = arraylist_size(num->digits) * 9 + 2;
-    char* result = (char*)malloc(max_size);
-    if (!result) return NULL;
+    size_t count;
+    uint32_t* groups = bignum_to_decimal_groups(num, &count);
+    if (!groups) return NULL;
+
+    // Каждая группа = до 9 цифр + знак + \0
+    char* result = (char*)counted_malloc(count * DECIMAL_GROUP_DIGITS + 2);
+    if (!result) {
+        free(groups);
+        return NULL;
+    }
 
     char* p = result;
 
@@ -122,17 +280,17 @@ char* bignum_to_string(const BigNum* num) {
         *p++ = '-';
     }
 
-    // Старший разряд без ведущих нулей
-    size_t size = arraylist_size(num->digits);
-    int written = sprintf(p, "%u", arraylist_get(num->digits, size - 1));
-    p += written;
+    // Старшая группа без ведущих нулей
+    p += bignum_format_group_head(p, groups[count - 1]);
 
-    // Остальные разряды с ведущими нулями (ровно 9 цифр)
-    for (size_t i = size - 1; i > 0; i--) {
-        written = sprintf(p, "%09u", arraylist_get(num->digits, i - 1));
-        p += written;
+    // Остальные группы с ведущими нулями (ровно 9 цифр)
+    for (size_t i = count - 1; i > 0; i--) {
+        bignum_format_group(p, groups[i - 1]);
+        p += DECIMAL_GROUP_DIGITS;
     }
+    *p = '\0';
 
+    free(groups);
     return result;
 }
 
@@ -185,123 +343,239 @@ BigNum* bignum_clone(const BigNum* num) {
     BigNum* clone = bignum_create();
     if (!clone) return NULL;
 
-    arraylist_free(clone->digits);
-    clone->digits = arraylist_clone(num->digits);
-    clone->is_negative = num->is_negative;
-
+    if (!bignum_assign(clone, num)) {
+        bignum_free(clone);
+        return NULL;
+    }
     return clone;
 }
 
-static BigNum* bignum_add_abs(const BigNum* a, const BigNum* b) {
-    BigNum* result = bignum_create();
-    arraylist_clear(result->digits);
+bool bignum_assign(BigNum* dst, const BigNum* src) {
+    if (dst == src) return true;
 
-    size_t max_size = arraylist_size(a->digits) > arraylist_size(b->digits) ?
-                      arraylist_size(a->digits) : arraylist_size(b->digits);
+    size_t size = arraylist_size(src->digits);
+    arraylist_resize(dst->digits, size);
+    if (arraylist_size(dst->digits) != size) return false;
 
-    uint64_t carry = 0;
-    for (size_t i = 0; i < max_size || carry; i++) {
-        uint64_t sum = carry;
-        if (i < arraylist_size(a->digits)) {
-            sum += arraylist_get(a->digits, i);
-        }
-        if (i < arraylist_size(b->digits)) {
-            sum += arraylist_get(b->digits, i);
-        }
+    memcpy(dst->digits->data, src->digits->data, size * sizeof(uint32_t));
+    dst->is_negative = src->is_negative;
+    return true;
+}
 
-        arraylist_push(result->digits, sum % BASE);
-        carry = sum / BASE;
+// |dst| = |a| + |b|; dst может совпадать с a или b
+static bool bignum_add_abs_into(BigNum* dst, const BigNum* a, const BigNum* b) {
+    if (arraylist_size(a->digits) < arraylist_size(b->digits)) {
+        const BigNum* t = a; a = b; b = t;
     }
+    size_t size_a = arraylist_size(a->digits);
+    size_t size_b = arraylist_size(b->digits);
 
-    bignum_normalize(result);
-    return result;
+    // Размеры запомнены до resize: при dst == a (или b) новые разряды — нули
+    arraylist_resize(dst->digits, size_a + 1);
+    if (arraylist_size(dst->digits) != size_a + 1) return false;
+
+    uint32_t* r = dst->digits->data;
+    const uint32_t* x = a->digits->data;
+    uint32_t carry = limbs_add_n(r, x, b->digits->data, size_b);
+    r[size_a] = limbs_add_1(r + size_b, x + size_b, size_a - size_b, carry);
+    return true;
 }
 
-static BigNum* bignum_subtract_abs(const BigNum* a, const BigNum* b) {
-    // Предполагаем, что |a| >= |b|
-    BigNum* result = bignum_create();
-    arraylist_clear(result->digits);
+// |dst| = |a| - |b|, где |a| >= |b|; dst может совпадать с a или b
+static bool bignum_subtract_abs_into(BigNum* dst, const BigNum* a, const BigNum* b) {
+    size_t size_a = arraylist_size(a->digits);
+    size_t size_b = arraylist_size(b->digits);
 
-    int64_t borrow = 0;
-    for (size_t i = 0; i < arraylist_size(a->digits); i++) {
-        int64_t diff = (int64_t)arraylist_get(a->digits, i) - borrow;
-        if (i < arraylist_size(b->digits)) {
-            diff -= arraylist_get(b->digits, i);
-        }
+    arraylist_resize(dst->digits, size_a);
+    if (arraylist_size(dst->digits) != size_a) return false;
 
-        if (diff < 0) {
-            diff += BASE;
-            borrow = 1;
-        } else {
-            borrow = 0;
-        }
+    uint32_t* r = dst->digits->data;
+    const uint32_t* x = a->digits->data;
+    uint32_t borrow = limbs_sub_n(r, x, b->digits->data, size_b);
+    limbs_sub_1(r + size_b, x + size_b, size_a - size_b, borrow);
+    return true;
+}
+
+// dst = a + (b со знаком b_negative)
+static bool bignum_add_signed_into(BigNum* dst, const BigNum* a, const BigNum* b, bool b_negative) {
+    bool a_negative = a->is_negative;
+    bool ok;
 
-        arraylist_push(result->digits, (uint32_t)diff);
+    if (bignum_fixed_add(dst, a, b, b_negative)) {
+        return true;
     }
 
-    bignum_normalize(result);
-    return result;
-}
+    if (a_negative == b_negative) {
+        ok = bignum_add_abs_into(dst, a, b);
+        dst->is_negative = a_negative;
+    } else if (bignum_compare_abs(a, b) >= 0) {
+        // Разные знаки: вычитание
+        ok = bignum_subtract_abs_into(dst, a, b);
+        dst->is_negative = a_negative;
+    } else {
+        ok = bignum_subtract_abs_into(dst, b, a);
+        dst->is_negative = b_negative;
+    }
 
-BigNum* bignum_add(const BigNum* a, const BigNum* b) {
-    if (a->is_negative == b->is_negative) {
-        BigNum* result = bignum_add_abs(a, b);
-        result->is_negative = a->is_negative;
-        return result;
+    if (ok) {
+        bignum_normalize(dst);
     }
+    return ok;
+}
 
-    // Разные знаки: вычитание
-    int cmp = bignum_compare_abs(a, b);
-    if (cmp == 0) {
-        return bignum_from_int(0);
+bool bignum_add_into(BigNum* dst, const BigNum* a, const BigNum* b) {
+    return bignum_add_signed_into(dst, a, b, b->is_negative);
+}
+
+bool bignum_subtract_into(BigNum* dst, const BigNum* a, const BigNum* b) {
+    return bignum_add_signed_into(dst, a, b, !b->is_negative);
+}
+
+bool bignum_multiply_into(BigNum* dst, const BigNum* a, const BigNum* b) {
+    size_t size_a = arraylist_size(a->digits);
+    size_t size_b = arraylist_size(b->digits);
+    bool negative = a->is_negative != b->is_negative;
+
+    if (bignum_fixed_mul(dst, a, b)) {
+        return true;
     }
 
-    BigNum* result;
-    if (cmp > 0) {
-        result = bignum_subtract_abs(a, b);
-        result->is_negative = a->is_negative;
+    if (dst != a && dst != b) {
+        arraylist_resize(dst->digits, size_a + size_b);
+        if (arraylist_size(dst->digits) != size_a + size_b ||
+            !bignum_mul_limbs(dst->digits->data, a->digits->data, size_a,
+                              b->digits->data, size_b)) {
+            return false;
+        }
     } else {
-        result = bignum_subtract_abs(b, a);
-        result->is_negative = b->is_negative;
+        // Произведение нельзя писать поверх множителя: считаем в новый буфер
+        ArrayList product;
+        arraylist_init_in(&product, dst->digits->arena);
+
+        arraylist_resize(&product, size_a + size_b);
+        if (arraylist_size(&product) != size_a + size_b ||
+            !bignum_mul_limbs(product.data, a->digits->data, size_a,
+                              b->digits->data, size_b)) {
+            arraylist_destroy(&product);
+            return false;
+        }
+
+        arraylist_swap(dst->digits, &product);
+        arraylist_destroy(&product);
     }
 
+    dst->is_negative = negative;
+    bignum_normalize(dst);
+    return true;
+}
+
+// Обёртка «создать результат и посчитать в него» для функций *_into
+static BigNum* bignum_compute(bool (*into)(BigNum*, const BigNum*, const BigNum*),
+                              const BigNum* a, const BigNum* b) {
+    BigNum* result = bignum_create();
+    if (!result) return NULL;
+
+    if (!into(result, a, b)) {
+        bignum_free(result);
+        return NULL;
+    }
     return result;
 }
 
+BigNum* bignum_add(const BigNum* a, const BigNum* b) {
+    return bignum_compute(bignum_add_into, a, b);
+}
+
 BigNum* bignum_subtract(const BigNum* a, const BigNum* b) {
-    BigNum* neg_b = bignum_clone(b);
-    neg_b->is_negative = !neg_b->is_negative;
+    return bignum_compute(bignum_subtract_into, a, b);
+}
 
-    BigNum* result = bignum_add(a, neg_b);
+BigNum* bignum_multiply(const BigNum* a, const BigNum* b) {
+    return bignum_compute(bignum_multiply_into, a, b);
+}
 
-    bignum_free(neg_b);
-    return result;
+bool bignum_square_into(BigNum* dst, const BigNum* a) {
+    // Совпадающие множители распознаются в bignum_mul_limbs
+    return bignum_multiply_into(dst, a, a);
 }
 
-BigNum* bignum_multiply(const BigNum* a, const BigNum* b) {
-    BigNum* result = bignum_create();
-    arraylist_clear(result->digits);
+BigNum* bignum_square(const BigNum* a) {
+    return bignum_multiply(a, a);
+}
 
-    size_t size_a = arraylist_size(a->digits);
-    size_t size_b = arraylist_size(b->digits);
-    arraylist_resize(result->digits, size_a + size_b);
+size_t bignum_pow_size(const BigNum* base, uint64_t exponent) {
+    // В base^exponent не больше bits * exponent бит
+    size_t limbs = arraylist_size(base->digits);
+    uint64_t bits = 32 * (uint64_t)(limbs - 1);
+    for (uint32_t top = base->digits->data[limbs - 1]; top; top >>= 1) {
+        bits++;
+    }
+    if (exponent == 0 || bits <= 1) return 1;
+    if (exponent > (UINT64_MAX - 31) / bits) return SIZE_MAX;
+
+    uint64_t size = (bits * exponent + 31) / 32;
+    return size > SIZE_MAX ? SIZE_MAX : (size_t)size;
+}
 
-    for (size_t i = 0; i < size_a; i++) {
-        uint64_t carry = 0;
-        uint64_t digit_a = arraylist_get(a->digits, i);
+bool bignum_pow_into(BigNum* dst, const BigNum* base, uint64_t exponent) {
+    if (exponent == 0) {
+        arraylist_resize(dst->digits, 1);
+        dst->digits->data[0] = 1;
+        dst->is_negative = false;
+        return true;
+    }
 
-        for (size_t j = 0; j < size_b || carry; j++) {
-            uint64_t digit_b = (j < size_b) ? arraylist_get(b->digits, j) : 0;
-            uint64_t current = arraylist_get(result->digits, i + j);
+    // Непомерный результат отклоняется до первого возведения в квадрат
+    if (bignum_pow_size(base, exponent) > BIGNUM_MAX_LIMBS) {
+        return false;
+    }
 
-            uint64_t prod = current + digit_a * digit_b + carry;
-            arraylist_set(result->digits, i + j, prod % BASE);
-            carry = prod / BASE;
+    // dst затирается первым же шагом, поэтому совпадающее основание копируем
+    BigNum* copy = NULL;
+    if (dst == base) {
+        copy = bignum_clone(base);
+        if (!copy) return false;
+        base = copy;
+    }
+
+    // Слева направо по битам показателя: квадрат на каждый бит,
+    // умножение на (короткое) основание — на единичных
+    int bit = 63;
+    while (!((exponent >> bit) & 1)) {
+        bit--;
+    }
+
+    bool ok = bignum_assign(dst, base);
+    while (ok && bit-- > 0) {
+        ok = bignum_square_into(dst, dst);
+        if (ok && ((exponent >> bit) & 1)) {
+            ok = bignum_multiply_into(dst, dst, base);
         }
     }
 
-    result->is_negative = (a->is_negative != b->is_negative);
-    bignum_normalize(result);
+    bignum_free(copy);
+    return ok;
+}
+
+bool bignum_to_uint64(const BigNum* num, uint64_t* value) {
+    size_t size = arraylist_size(num->digits);
+    if (size > 2 || (num->is_negative && !bignum_is_zero(num))) return false;
 
+    uint64_t result = 0;
+    for (size_t i = size; i > 0; i--) {
+        result = (result << 32) | num->digits->data[i - 1];
+    }
+    *value = result;
+    return true;
+}
+
+BigNum* bignum_pow(const BigNum* base, uint64_t exponent) {
+    BigNum* result = bignum_create();
+    if (!result) return NULL;
+
+    if (!bignum_pow_into(result, base, exponent)) {
+        bignum_free(result);
+        return NULL;
+    }
     return result;
 }
@@ -0,0 +1,324 @@
+#include "bignum_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Перевод между двоичными разрядами и десятичными группами по 10^9 цифр.
+// Короткие числа переводятся схемой Горнера, длинные — делением пополам
+// по степеням 10^(9 * 2^k) из кэша, так что стоимость определяется
+// быстрым умножением и делением, а не квадратом длины.
+
+// Порог (в десятичных группах), ниже которого работает схема Горнера
+#define CONV_THRESHOLD 32
+
+#define POW10_CACHE_SIZE 48
+
+// pow10_cache[k] = 10^(9 * 2^k), pow10_inverse[k] — его обратное для деления
+// по Барретту; растут по мере надобности и живут до конца процесса.
+// Заполняются под pow10_lock (перевод может идти из нескольких потоков);
+// готовые элементы больше не меняются, и ими пользуются уже без блокировки.
+static BigNum* pow10_cache[POW10_CACHE_SIZE];
+static BigNum* pow10_inverse[POW10_CACHE_SIZE];
+static pthread_mutex_t pow10_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Вызывается под pow10_lock
+static const BigNum* decimal_power_locked(int level) {
+    for (int k = 0; k <= level; k++) {
+        if (pow10_cache[k]) continue;
+
+        if (k == 0) {
+            pow10_cache[0] = bignum_from_int(DECIMAL_GROUP_BASE);
+        } else if (pow10_cache[k - 1]) {
+            pow10_cache[k] = bignum_square(pow10_cache[k - 1]);
+        }
+    }
+    return pow10_cache[level];
+}
+
+static const BigNum* decimal_power(int level) {
+    if (level >= POW10_CACHE_SIZE) return NULL;
+
+    pthread_mutex_lock(&pow10_lock);
+    const BigNum* power = decimal_power_locked(level);
+    pthread_mutex_unlock(&pow10_lock);
+    return power;
+}
+
+static const BigNum* decimal_power_inverse(int level) {
+    if (level >= POW10_CACHE_SIZE) return NULL;
+
+    pthread_mutex_lock(&pow10_lock);
+    if (!pow10_inverse[level]) {
+        const BigNum* power = decimal_power_locked(level);
+        pow10_inverse[level] = power ? bignum_reciprocal(power) : NULL;
+    }
+    const BigNum* inverse = pow10_inverse[level];
+    pthread_mutex_unlock(&pow10_lock);
+    return inverse;
+}
+
+// result = groups[0 .. count) по Горнеру: result = result * 10^9 + группа
+static bool from_decimal_basecase(BigNum* result, const uint32_t* groups, size_t count) {
+    // 10^9 < 2^32, поэтому на каждую группу нужно не больше одного разряда
+    arraylist_clear(result->digits);
+    arraylist_resize(result->digits, count);
+    if (arraylist_size(result->digits) != count) return false;
+
+    uint32_t* r = result->digits->data;
+    size_t used = 0;
+    for (size_t i = count; i > 0; i--) {
+        // Старший разряд после умножения меньше 10^9, так что сумма влезает в разряд
+        uint32_t carry = limbs_mul_1(r, r, used, DECIMAL_GROUP_BASE);
+        carry += limbs_add_1(r, r, used, groups[i - 1]);
+        if (carry) {
+            r[used++] = carry;
+        }
+    }
+
+    bignum_normalize(result);
+    return true;
+}
+
+// Уровень k, для которого 2^k < count <= 2^(k+1)
+static int split_level(size_t count) {
+    int level = 0;
+    while (((size_t)2 << level) < count) {
+        level++;
+    }
+    return level;
+}
+
+static BigNum* from_decimal(const uint32_t* groups, size_t count) {
+    if (count <= CONV_THRESHOLD) {
+        BigNum* result = bignum_create();
+        if (result && !from_decimal_basecase(result, groups, count)) {
+            bignum_free(result);
+            return NULL;
+        }
+        return result;
+    }
+
+    // groups = hi * 10^(9 * half) + lo
+    int level = split_level(count);
+    size_t half = (size_t)1 << level;
+
+    const BigNum* power = decimal_power(level);
+    BigNum* lo = power ? from_decimal(groups, half) : NULL;
+    BigNum* hi = lo ? from_decimal(groups + half, count - half) : NULL;
+
+    bool ok = hi && bignum_multiply_into(hi, hi, power) && bignum_add_into(hi, hi, lo);
+
+    bignum_free(lo);
+    if (!ok) {
+        bignum_free(hi);
+        return NULL;
+    }
+    return hi;
+}
+
+bool bignum_set_decimal_groups(BigNum* dst, const uint32_t* groups, size_t count) {
+    bool negative = dst->is_negative;
+    if (count <= CONV_THRESHOLD) {
+        return from_decimal_basecase(dst, groups, count);
+    }
+
+    BigNum* value = from_decimal(groups, count);
+    bool ok = value && bignum_assign(dst, value);
+    dst->is_negative = negative;
+    bignum_free(value);
+    return ok;
+}
+
+// Ровно 2^level групп числа x (0 <= x < 10^(9 * 2^level)) в out, с ведущими нулями
+static bool to_decimal(const BigNum* x, int level, uint32_t* out) {
+    size_t count = (size_t)1 << level;
+
+    if (count <= CONV_THRESHOLD) {
+        BigNum* rest = bignum_clone(x);
+        if (!rest) return false;
+
+        for (size_t i = 0; i < count; i++) {
+            out[i] = bignum_div_small(rest, DECIMAL_GROUP_BASE);
+        }
+        bignum_free(rest);
+        return true;
+    }
+
+    BigNum* q = NULL;
+    BigNum* r = NULL;
+    // x < 10^(9 * 2^level) = power^2, поэтому подходит деление по Барретту
+    const BigNum* power = decimal_power(level - 1);
+    const BigNum* inverse = decimal_power_inverse(level - 1);
+
+    bool ok = power && inverse && bignum_divmod_reciprocal(x, power, inverse, &q, &r) &&
+              to_decimal(r, level - 1, out) &&
+              to_decimal(q, level - 1, out + count / 2);
+
+    bignum_free(q);
+    bignum_free(r);
+    return ok;
+}
+
+// Уровень, на котором x >= 0 заведомо помещается в 2^level групп, по длине
+// в битах: сама степень 10^(9 * 2^level) не нужна, перевод делит только на
+// меньшие. Уровень может оказаться на единицу выше наименьшего — тогда
+// старшие группы выйдут нулевыми.
+static int decimal_level(const BigNum* x) {
+    size_t n = arraylist_size(x->digits);
+    uint64_t bits = 32 * (uint64_t)(n - 1);
+    for (uint32_t top = x->digits->data[n - 1]; top; top >>= 1) {
+        bits++;
+    }
+
+    // Десятичных цифр не больше bits * log10(2) + 1, 0.30103 > log10(2)
+    uint64_t digits = bits * 30103 / 100000 + 1;
+    uint64_t groups = (digits + DECIMAL_GROUP_DIGITS - 1) / DECIMAL_GROUP_DIGITS;
+    int level = 0;
+    while (((uint64_t)1 << level) < groups) {
+        level++;
+    }
+    return level < POW10_CACHE_SIZE ? level : -1;
+}
+
+uint32_t* bignum_to_decimal_groups(const BigNum* num, size_t* count) {
+    BigNum* x = bignum_clone(num);
+    if (!x) return NULL;
+    x->is_negative = false;
+
+    int level = decimal_level(x);
+    uint32_t* groups = NULL;
+    if (level >= 0) {
+        groups = (uint32_t*)counted_malloc(((size_t)1 << level) * sizeof(uint32_t));
+    }
+    if (groups && !to_decimal(x, level, groups)) {
+        free(groups);
+        groups = NULL;
+    }
+    bignum_free(x);
+    if (!groups) return NULL;
+
+    // Отбрасываем ведущие нулевые группы, оставляя хотя бы одну
+    size_t n = (size_t)1 << level;
+    while (n > 1 && groups[n - 1] == 0) {
+        n--;
+    }
+    *count = n;
+    return groups;
+}
+
+// Размер буфера bignum_write и bignum_write_hex: цифры уходят в файл кусками такой длины
+#define WRITE_BUFFER_SIZE (1 << 20)
+
+typedef struct {
+    FILE* file;
+    char* buffer;
+    size_t used;
+    bool started;   // Ведущие нулевые группы уже пропущены
+    bool ok;
+} OutputWriter;
+
+static void writer_flush(OutputWriter* w) {
+    if (w->ok && w->used > 0 && fwrite(w->buffer, 1, w->used, w->file) != w->used) {
+        w->ok = false;
+    }
+    w->used = 0;
+}
+
+// Группы groups[0 .. count) от старшей к младшей
+static void writer_put_groups(OutputWriter* w, const uint32_t* groups, size_t count) {
+    for (size_t i = count; i > 0; i--) {
+        if (w->used + DECIMAL_GROUP_DIGITS > WRITE_BUFFER_SIZE) {
+            writer_flush(w);
+        }
+        char* p = w->buffer + w->used;
+        if (w->started) {
+            bignum_format_group(p, groups[i - 1]);
+            w->used += DECIMAL_GROUP_DIGITS;
+        } else if (groups[i - 1] != 0) {
+            w->used += bignum_format_group_head(p, groups[i - 1]);
+            w->started = true;
+        }
+    }
+}
+
+// Как to_decimal, но группы сразу печатаются: сначала старшая половина,
+// которая освобождается до перевода младшей
+static bool write_decimal(const BigNum* x, int level, OutputWriter* w) {
+    size_t count = (size_t)1 << level;
+
+    if (count <= CONV_THRESHOLD) {
+        uint32_t groups[CONV_THRESHOLD];
+        if (!to_decimal(x, level, groups)) return false;
+        writer_put_groups(w, groups, count);
+        return w->ok;
+    }
+
+    BigNum* q = NULL;
+    BigNum* r = NULL;
+    const BigNum* power = decimal_power(level - 1);
+    const BigNum* inverse = decimal_power_inverse(level - 1);
+
+    bool ok = power && inverse && bignum_divmod_reciprocal(x, power, inverse, &q, &r);
+    ok = ok && write_decimal(q, level - 1, w);
+    bignum_free(q);
+    ok = ok && write_decimal(r, level - 1, w);
+    bignum_free(r);
+    return ok;
+}
+
+bool bignum_write(FILE* file, const BigNum* num) {
+    if (!num || arraylist_size(num->digits) == 0 || bignum_is_zero(num)) {
+        return fputc('0', file) != EOF;
+    }
+
+    OutputWriter w = {file, (char*)counted_malloc(WRITE_BUFFER_SIZE), 0, false, true};
+    if (!w.buffer) return false;
+    if (num->is_negative) {
+        w.buffer[w.used++] = '-';
+    }
+
+    // Модуль без копирования разрядов: x ссылается на разряды num
+    BigNum x = *num;
+    x.is_negative = false;
+
+    int level = decimal_level(&x);
+    bool ok = level >= 0 && write_decimal(&x, level, &w);
+    writer_flush(&w);
+    free(w.buffer);
+    return ok && w.ok;
+}
+
+static const char hex_digits[] = "0123456789abcdef";
+
+bool bignum_write_hex(FILE* file, const BigNum* num) {
+    OutputWriter w = {file, (char*)counted_malloc(WRITE_BUFFER_SIZE), 0, true, true};
+    if (!w.buffer) return false;
+    if (num->is_negative && !bignum_is_zero(num)) {
+        w.buffer[w.used++] = '-';
+    }
+    w.buffer[w.used++] = '0';
+    w.buffer[w.used++] = 'x';
+
+    // Разряд — ровно 8 цифр, у старшего ведущие нули отбрасываются
+    size_t n = arraylist_size(num->digits);
+    const uint32_t* d = num->digits->data;
+    int skip = 7;
+    while (n > 0 && skip > 0 && (d[n - 1] >> (4 * skip)) == 0) {
+        skip--;
+    }
+    for (size_t i = n; i > 0; i--) {
+        if (w.used + 8 > WRITE_BUFFER_SIZE) {
+            writer_flush(&w);
+        }
+        for (int k = i == n ? skip : 7; k >= 0; k--) {
+            w.buffer[w.used++] = hex_digits[(d[i - 1] >> (4 * k)) & 0xf];
+        }
+    }
+    if (n == 0) {
+        w.buffer[w.used++] = '0';
+    }
+
+    writer_flush(&w);
+    free(w.buffer);
+    return w.ok;
+}
@@ -0,0 +1,547 @@
+#include "bignum_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Порог (в разрядах делителя), начиная с которого вместо алгоритма D Кнута
+// используется рекурсивное деление Бурникеля–Циглера
+#define BZ_THRESHOLD 160
+
+// Алгоритм D Кнута: u[0 .. un) / v[0 .. vn), где vn >= 2, un >= vn, v[vn - 1] != 0.
+// q получает un - vn + 1 разрядов, r — vn разрядов.
+static bool knuth_divmod(const uint32_t* u, size_t un, const uint32_t* v, size_t vn,
+                         uint32_t* q, uint32_t* r) {
+    uint32_t* mem = (uint32_t*)counted_malloc((un + 1 + vn) * sizeof(uint32_t));
+    if (!mem) return false;
+
+    // Нормализация: старший разряд делителя становится >= BASE / 2
+    uint32_t d = (uint32_t)(BASE / ((uint64_t)v[vn - 1] + 1));
+    uint32_t* w = mem;
+    uint32_t* y = mem + un + 1;
+    w[un] = limbs_mul_1(w, u, un, d);
+    limbs_mul_1(y, v, vn, d);
+
+    uint64_t y_top = y[vn - 1];
+    uint64_t y_next = y[vn - 2];
+
+    for (size_t j = un - vn + 1; j-- > 0;) {
+        // Оценка разряда частного по двум старшим разрядам
+        uint64_t num = (uint64_t)w[j + vn] * BASE + w[j + vn - 1];
+        uint64_t qhat = num / y_top;
+        uint64_t rhat = num % y_top;
+
+        while (qhat >= BASE || qhat * y_next > rhat * BASE + w[j + vn - 2]) {
+            qhat--;
+            rhat += y_top;
+            if (rhat >= BASE) break;
+        }
+
+        // w[j .. j + vn] -= qhat * y; qhat < BASE после уточнения выше
+        int64_t top = (int64_t)w[j + vn] - limbs_submul_1(w + j, y, vn, (uint32_t)qhat);
+
+        // Оценка оказалась на единицу больше: возвращаем делитель обратно
+        if (top < 0) {
+            qhat--;
+            top += limbs_add_n(w + j, w + j, y, vn);
+        }
+
+        w[j + vn] = (uint32_t)top;
+        q[j] = (uint32_t)qhat;
+    }
+
+    // Денормализация остатка
+    uint64_t rem = 0;
+    for (size_t i = vn; i > 0; i--) {
+        uint64_t cur = w[i - 1] + rem * BASE;
+        r[i - 1] = (uint32_t)(cur / d);
+        rem = cur % d;
+    }
+
+    free(mem);
+    return true;
+}
+
+static void set_small(BigNum* num, uint32_t value) {
+    arraylist_clear(num->digits);
+    arraylist_push(num->digits, value);
+    num->is_negative = false;
+}
+
+// Деление модулей «в лоб» (короткое деление или алгоритм D) с записью прямо
+// в quotient и remainder; любой из них может быть NULL или совпадать с a и b,
+// но не друг с другом
+static bool divmod_basecase_into(BigNum* quotient, BigNum* remainder, const BigNum* a,
+                                 const BigNum* b) {
+    size_t an = arraylist_size(a->digits);
+    size_t bn = arraylist_size(b->digits);
+
+    if (bignum_compare_abs(a, b) < 0) {
+        if (remainder) {
+            if (!bignum_assign(remainder, a)) return false;
+            remainder->is_negative = false;
+        }
+        if (quotient) {
+            set_small(quotient, 0);
+        }
+        return true;
+    }
+
+    if (bn == 1) {
+        uint32_t divisor = b->digits->data[0];
+        uint32_t rem;
+        if (quotient) {
+            if (!bignum_assign(quotient, a)) return false;
+            quotient->is_negative = false;
+            rem = bignum_div_small(quotient, divisor);
+        } else {
+            uint64_t cur = 0;
+            for (size_t i = an; i > 0; i--) {
+                cur = ((cur << 32) | a->digits->data[i - 1]) % divisor;
+            }
+            rem = (uint32_t)cur;
+        }
+        if (remainder) {
+            set_small(remainder, rem);
+        }
+        return true;
+    }
+
+    // Алгоритм D читает a и b только до первой записи, поэтому ответ можно писать
+    // в их разряды. Опасен лишь рост quotient == b (буфер b переедет), тогда,
+    // как и без quotient, частное идёт во временный буфер
+    size_t qn = an - bn + 1;
+    const uint32_t* u = a->digits->data;
+    const uint32_t* v = b->digits->data;
+    bool q_direct = quotient && quotient != b;
+    uint32_t* tmp = NULL;
+    if (!q_direct || !remainder) {
+        tmp = (uint32_t*)counted_malloc(((q_direct ? 0 : qn) + (remainder ? 0 : bn)) *
+                                        sizeof(uint32_t));
+        if (!tmp) return false;
+    }
+
+    uint32_t* q = tmp;
+    uint32_t* r = tmp + (q_direct ? 0 : qn);
+    bool ok = true;
+    if (q_direct) {
+        arraylist_resize(quotient->digits, qn);
+        ok = arraylist_size(quotient->digits) == qn;
+        q = quotient->digits->data;
+    }
+    if (ok && remainder) {
+        // Остаток не длиннее a и b, так что их буферы при этом не двигаются
+        arraylist_resize(remainder->digits, bn);
+        ok = arraylist_size(remainder->digits) == bn;
+        r = remainder->digits->data;
+    }
+    ok = ok && knuth_divmod(u, an, v, bn, q, r);
+
+    if (ok && quotient) {
+        if (!q_direct) {
+            arraylist_resize(quotient->digits, qn);
+            ok = arraylist_size(quotient->digits) == qn;
+            if (ok) {
+                memcpy(quotient->digits->data, q, qn * sizeof(uint32_t));
+            }
+        }
+        quotient->is_negative = false;
+        bignum_normalize(quotient);
+    }
+    if (ok && remainder) {
+        remainder->is_negative = false;
+        bignum_normalize(remainder);
+    }
+
+    free(tmp);
+    return ok;
+}
+
+static bool divmod_basecase(const BigNum* a, const BigNum* b, BigNum** q, BigNum** r) {
+    *q = bignum_create();
+    *r = bignum_create();
+    return *q && *r && divmod_basecase_into(*q, *r, a, b);
+}
+
+// x div BASE^k
+static BigNum* limbs_high(const BigNum* x, size_t k) {
+    size_t n = arraylist_size(x->digits);
+    return n > k ? bignum_from_limbs(x->digits->data + k, n - k) : bignum_create();
+}
+
+// x mod BASE^k
+static BigNum* limbs_low(const BigNum* x, size_t k) {
+    size_t n = arraylist_size(x->digits);
+    return bignum_from_limbs(x->digits->data, n < k ? n : k);
+}
+
+// x * BASE^k + y (x, y >= 0, y < BASE^k; y == NULL означает ноль)
+static BigNum* limbs_join(const BigNum* x, size_t k, const BigNum* y) {
+    if (bignum_is_zero(x)) {
+        return y ? bignum_clone(y) : bignum_create();
+    }
+
+    size_t xn = arraylist_size(x->digits);
+    size_t yn = (!y || bignum_is_zero(y)) ? 0 : arraylist_size(y->digits);
+
+    BigNum* result = bignum_create();
+    if (!result) return NULL;
+
+    arraylist_resize(result->digits, xn + k);
+    if (arraylist_size(result->digits) != xn + k) {
+        bignum_free(result);
+        return NULL;
+    }
+    if (yn > 0) {
+        memcpy(result->digits->data, y->digits->data, yn * sizeof(uint32_t));
+    }
+    memcpy(result->digits->data + k, x->digits->data, xn * sizeof(uint32_t));
+    return result;
+}
+
+static bool div_3n_2n(const BigNum* a, const BigNum* b, const BigNum* b1, const BigNum* b2,
+                      size_t k, BigNum** q, BigNum** r);
+
+// Бурникель–Циглер: a < b * BASE^n, b ровно из n разрядов, нормализован
+static bool div_2n_1n(const BigNum* a, const BigNum* b, size_t n, BigNum** q, BigNum** r) {
+    if (n < BZ_THRESHOLD) {
+        return divmod_basecase(a, b, q, r);
+    }
+
+    // Нечётное n: домножаем на BASE, частное не меняется, остаток сдвигается
+    if (n % 2 == 1) {
+        BigNum* a_shift = limbs_join(a, 1, NULL);
+        BigNum* b_shift = limbs_join(b, 1, NULL);
+        BigNum* r_shift = NULL;
+
+        bool ok = a_shift && b_shift && div_2n_1n(a_shift, b_shift, n + 1, q, &r_shift) &&
+                  (*r = limbs_high(r_shift, 1)) != NULL;
+
+        bignum_free(a_shift);
+        bignum_free(b_shift);
+        bignum_free(r_shift);
+        return ok;
+    }
+
+    size_t k = n / 2;
+    BigNum* b1 = limbs_high(b, k);
+    BigNum* b2 = limbs_low(b, k);
+    BigNum* a123 = limbs_high(a, k);
+    BigNum* a4 = limbs_low(a, k);
+    BigNum* q1 = NULL;
+    BigNum* q2 = NULL;
+    BigNum* r1 = NULL;
+    BigNum* t = NULL;
+
+    bool ok = b1 && b2 && a123 && a4 &&
+              div_3n_2n(a123, b, b1, b2, k, &q1, &r1) &&
+              bignum_replace(&t, limbs_join(r1, k, a4)) &&
+              div_3n_2n(t, b, b1, b2, k, &q2, r) &&
+              (*q = limbs_join(q1, k, q2)) != NULL;
+
+    bignum_free(b1);
+    bignum_free(b2);
+    bignum_free(a123);
+    bignum_free(a4);
+    bignum_free(q1);
+    bignum_free(q2);
+    bignum_free(r1);
+    bignum_free(t);
+    return ok;
+}
+
+// a < b * BASE^k, b = b1 * BASE^k + b2 из 2k разрядов
+static bool div_3n_2n(const BigNum* a, const BigNum* b, const BigNum* b1, const BigNum* b2,
+                      size_t k, BigNum** q, BigNum** r) {
+    BigNum* a1 = limbs_high(a, 2 * k);
+    BigNum* a12 = limbs_high(a, k);
+    BigNum* a3 = limbs_low(a, k);
+    BigNum* r1 = NULL;
+    BigNum* t = NULL;
+    BigNum* one = bignum_from_int(1);
+    bool ok = a1 && a12 && a3 && one;
+
+    if (ok && bignum_compare(a1, b1) < 0) {
+        ok = div_2n_1n(a12, b1, k, q, &r1);
+    } else if (ok) {
+        // Частное не меньше BASE^k - 1: r1 = a12 - b1 * BASE^k + b1
+        *q = bignum_create();
+        ok = *q != NULL;
+        if (ok) {
+            arraylist_clear((*q)->digits);
+            for (size_t i = 0; i < k; i++) {
+                arraylist_push((*q)->digits, BASE - 1);
+            }
+        }
+        ok = ok && bignum_replace(&t, limbs_join(b1, k, NULL)) &&
+             (r1 = bignum_subtract(a12, t)) != NULL &&
+             bignum_replace(&r1, bignum_add(r1, b1));
+    }
+
+    // r = r1 * BASE^k + a3 - q * b2, при r < 0 частное завышено не более чем на 2
+    ok = ok && bignum_replace(&t, bignum_multiply(*q, b2)) &&
+         (*r = limbs_join(r1, k, a3)) != NULL &&
+         bignum_replace(r, bignum_subtract(*r, t));
+
+    while (ok && (*r)->is_negative) {
+        ok = bignum_replace(q, bignum_subtract(*q, one)) &&
+             bignum_replace(r, bignum_add(*r, b));
+    }
+
+    bignum_free(a1);
+    bignum_free(a12);
+    bignum_free(a3);
+    bignum_free(r1);
+    bignum_free(t);
+    bignum_free(one);
+    return ok;
+}
+
+// Деление модулей через Бурникеля–Циглера: делимое режется на блоки по n разрядов
+static bool divmod_recursive(const BigNum* a, const BigNum* b, BigNum** q, BigNum** r) {
+    uint32_t d = (uint32_t)(BASE / ((uint64_t)b->digits->data[arraylist_size(b->digits) - 1] + 1));
+    BigNum* factor = bignum_from_int(d);
+    BigNum* na = NULL;
+    BigNum* nb = NULL;
+    BigNum* rem = bignum_create();
+    BigNum* block = NULL;
+    BigNum* x = NULL;
+    BigNum* qi = NULL;
+
+    bool ok = factor && rem &&
+              (na = bignum_multiply(a, factor)) != NULL &&
+              (nb = bignum_multiply(b, factor)) != NULL &&
+              (*q = bignum_create()) != NULL;
+
+    if (ok) {
+        na->is_negative = nb->is_negative = false;
+
+        size_t n = arraylist_size(nb->digits);
+        size_t total = arraylist_size(na->digits);
+        size_t blocks = (total + n - 1) / n;
+
+        arraylist_resize((*q)->digits, blocks * n);
+        ok = arraylist_size((*q)->digits) == blocks * n;
+
+        for (size_t i = blocks; ok && i-- > 0;) {
+            size_t from = i * n;
+            size_t len = total - from < n ? total - from : n;
+
+            ok = bignum_replace(&block, bignum_from_limbs(na->digits->data + from, len)) &&
+                 bignum_replace(&x, limbs_join(rem, n, block));
+
+            bignum_free(rem);
+            bignum_free(qi);
+            rem = qi = NULL;
+            ok = ok && div_2n_1n(x, nb, n, &qi, &rem);
+
+            if (ok && !bignum_is_zero(qi)) {
+                memcpy((*q)->digits->data + from, qi->digits->data,
+                       arraylist_size(qi->digits) * sizeof(uint32_t));
+            }
+        }
+    }
+
+    if (ok) {
+        bignum_normalize(*q);
+        bignum_div_small(rem, d);
+        *r = rem;
+        rem = NULL;
+    }
+
+    bignum_free(factor);
+    bignum_free(na);
+    bignum_free(nb);
+    bignum_free(rem);
+    bignum_free(block);
+    bignum_free(x);
+    bignum_free(qi);
+    return ok;
+}
+
+// Ниже этого размера (в разрядах) обратное число считается прямым делением
+#define RECIPROCAL_THRESHOLD 64
+
+// BASE^k
+static BigNum* limbs_power(size_t k) {
+    BigNum* one = bignum_from_int(1);
+    BigNum* result = one ? limbs_join(one, k, NULL) : NULL;
+    bignum_free(one);
+    return result;
+}
+
+// x >> (32 * k) с сохранением знака
+static BigNum* limbs_high_signed(const BigNum* x, size_t k) {
+    BigNum* result = limbs_high(x, k);
+    if (result) {
+        result->is_negative = x->is_negative;
+        bignum_normalize(result);
+    }
+    return result;
+}
+
+BigNum* bignum_reciprocal(const BigNum* d) {
+    size_t n = arraylist_size(d->digits);
+
+    if (n <= RECIPROCAL_THRESHOLD) {
+        BigNum* unit = limbs_power(2 * n);
+        BigNum* result = unit ? bignum_divide(unit, d) : NULL;
+        bignum_free(unit);
+        return result;
+    }
+
+    // Приближение x0 = xh * BASE^(n-h) по старшим h разрядам делителя и один шаг
+    // Ньютона: x1 = x0 + x0 * (BASE^(2n) - d * x0) / BASE^(2n). Точность удваивается,
+    // поэтому h чуть больше n / 2 хватает, чтобы ошибка была в пределах пары единиц.
+    //
+    // BASE^(2n) - d * x0 = e * BASE^(n-h) при e = BASE^(n+h) - d * xh, и поправка
+    // равна xh * e / BASE^(2h). |e| порядка BASE^n, а его младшие h - 1 разрядов
+    // меняют поправку меньше чем на единицу и отбрасываются: оба умножения
+    // не длиннее n на n / 2 разрядов, а не n на n и n на 3n / 2.
+    size_t h = (n + 5) / 2;
+    BigNum* dh = limbs_high(d, n - h);
+    BigNum* xh = NULL;
+    BigNum* x = NULL;
+    BigNum* e = NULL;
+    BigNum* t = NULL;
+    BigNum* unit = limbs_power(n + h);
+    BigNum* one_unit = bignum_from_int(1);
+
+    bool ok = dh && unit && one_unit &&
+              (xh = bignum_reciprocal(dh)) != NULL &&
+              bignum_replace(&t, bignum_multiply(d, xh)) &&
+              (e = bignum_subtract(unit, t)) != NULL &&
+              bignum_replace(&t, limbs_high_signed(e, h - 1)) &&
+              bignum_replace(&t, bignum_multiply(xh, t)) &&
+              bignum_replace(&t, limbs_high_signed(t, h + 1)) &&
+              (x = limbs_join(xh, n - h, NULL)) != NULL;
+
+    // Полный остаток BASE^(2n) - d * x0 со знаком
+    if (ok) {
+        bool negative = e->is_negative;
+        ok = bignum_replace(&e, limbs_join(e, n - h, NULL));
+        if (ok) {
+            e->is_negative = negative;
+            bignum_normalize(e);
+        }
+    }
+
+    // e = BASE^(2n) - d * x1 = e - d * t; доводим до 0 <= e < d
+    ok = ok && bignum_add_into(x, x, t) &&
+         bignum_replace(&t, bignum_multiply(d, t)) &&
+         bignum_subtract_into(e, e, t);
+
+    while (ok && e->is_negative) {
+        ok = bignum_subtract_into(x, x, one_unit) && bignum_add_into(e, e, d);
+    }
+    while (ok && bignum_compare(e, d) >= 0) {
+        ok = bignum_add_into(x, x, one_unit) && bignum_subtract_into(e, e, d);
+    }
+
+    bignum_free(unit);
+    bignum_free(dh);
+    bignum_free(xh);
+    bignum_free(e);
+    bignum_free(t);
+    bignum_free(one_unit);
+    if (!ok) {
+        bignum_free(x);
+        return NULL;
+    }
+    return x;
+}
+
+bool bignum_divmod_reciprocal(const BigNum* x, const BigNum* d, const BigNum* inv,
+                              BigNum** quotient, BigNum** remainder) {
+    // Редукция Барретта: q = ((x / BASE^(n-1)) * inv) / BASE^(n+1), q <= x / d <= q + 2
+    size_t n = arraylist_size(d->digits);
+    BigNum* q = limbs_high(x, n - 1);
+    BigNum* r = NULL;
+    BigNum* t = NULL;
+    BigNum* one = bignum_from_int(1);
+
+    bool ok = q && one &&
+              bignum_multiply_into(q, q, inv) &&
+              bignum_replace(&q, limbs_high(q, n + 1)) &&
+              (t = bignum_multiply(q, d)) != NULL &&
+              (r = bignum_subtract(x, t)) != NULL;
+
+    while (ok && bignum_compare(r, d) >= 0) {
+        ok = bignum_add_into(q, q, one) && bignum_subtract_into(r, r, d);
+    }
+
+    bignum_free(t);
+    bignum_free(one);
+    if (!ok) {
+        bignum_free(q);
+        bignum_free(r);
+        return false;
+    }
+
+    *quotient = q;
+    *remainder = r;
+    return true;
+}
+
+bool bignum_divmod_into(BigNum* quotient, BigNum* remainder, const BigNum* a, const BigNum* b) {
+    if (bignum_is_zero(b)) return false;
+
+    size_t an = arraylist_size(a->digits);
+    size_t bn = arraylist_size(b->digits);
+    bool a_negative = a->is_negative;
+    bool q_negative = a->is_negative != b->is_negative;
+
+    bool ok;
+    if (bn < BZ_THRESHOLD || an < bn + BZ_THRESHOLD) {
+        ok = divmod_basecase_into(quotient, remainder, a, b);
+    } else {
+        // Рекурсия всё равно строит промежуточные числа в куче, копирование
+        // ответа на их фоне незаметно
+        BigNum* q = NULL;
+        BigNum* r = NULL;
+        ok = divmod_recursive(a, b, &q, &r) &&
+             (!quotient || bignum_assign(quotient, q)) &&
+             (!remainder || bignum_assign(remainder, r));
+        bignum_free(q);
+        bignum_free(r);
+    }
+    if (!ok) return false;
+
+    // Частное округляется к нулю, остаток имеет знак делимого
+    if (quotient) {
+        quotient->is_negative = q_negative;
+        bignum_normalize(quotient);
+    }
+    if (remainder) {
+        remainder->is_negative = a_negative;
+        bignum_normalize(remainder);
+    }
+    return true;
+}
+
+bool bignum_divmod(const BigNum* a, const BigNum* b, BigNum** quotient, BigNum** remainder) {
+    BigNum* q = quotient ? bignum_create() : NULL;
+    BigNum* r = remainder ? bignum_create() : NULL;
+
+    if ((quotient && !q) || (remainder && !r) || !bignum_divmod_into(q, r, a, b)) {
+        bignum_free(q);
+        bignum_free(r);
+        return false;
+    }
+
+    if (quotient) {
+        *quotient = q;
+    }
+    if (remainder) {
+        *remainder = r;
+    }
+    return true;
+}
+
+BigNum* bignum_divide(const BigNum* a, const BigNum* b) {
+    BigNum* q = NULL;
+    return bignum_divmod(a, b, &q, NULL) ? q : NULL;
+}
+
+BigNum* bignum_mod(const BigNum* a, const BigNum* b) {
+    BigNum* r = NULL;
+    return bignum_divmod(a, b, NULL, &r) ? r : NULL;
+}
@@ -0,0 +1,171 @@
+#include "bignum_internal.h"
+#include <string.h>
+
+// Быстрый путь для чисел до 256 бит: модуль лежит в четырёх 64-битных словах
+// на стеке, сложение и умножение идут без общего кода (выбора алгоритма,
+// временных буферов, цепочек вызовов ядер). Если результат не помещается
+// в 256 бит, функции возвращают false и вызывающий считает общим путём.
+
+#if defined(__SIZEOF_INT128__) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+#define FIXED_WORDS 4
+#define FIXED_LIMBS (2 * FIXED_WORDS)
+
+// Буфер разрядов никогда не меньше встроенного в ArrayList, поэтому его первые
+// FIXED_LIMBS разрядов можно читать и писать целиком, не глядя на размер
+_Static_assert(ARRAYLIST_INLINE_CAPACITY >= FIXED_LIMBS, "fixed path needs inline capacity");
+
+typedef unsigned __int128 u128;
+
+typedef struct {
+    uint64_t w[FIXED_WORDS];    // Младшие слова в начале; в памяти совпадает с разрядами
+    size_t words;               // Значащих слов (не больше; у нуля — 1)
+} Fixed;
+
+// false, если число длиннее 256 бит
+static inline bool fixed_load(Fixed* x, const BigNum* num) {
+    size_t size = num->digits->size;
+    if (size > FIXED_LIMBS) return false;
+
+    memcpy(x->w, num->digits->data, FIXED_LIMBS * sizeof(uint32_t));
+    memset((unsigned char*)x->w + size * sizeof(uint32_t), 0,
+           (FIXED_LIMBS - size) * sizeof(uint32_t));
+    x->words = (size + 1) / 2;
+    return true;
+}
+
+// Записывает модуль x со знаком negative в dst (нормализованно)
+static inline void fixed_store(BigNum* dst, const Fixed* x, bool negative) {
+    size_t size = FIXED_LIMBS;
+    const uint32_t* limbs = (const uint32_t*)x->w;
+    while (size > 1 && limbs[size - 1] == 0) {
+        size--;
+    }
+
+    memcpy(dst->digits->data, x->w, FIXED_LIMBS * sizeof(uint32_t));
+    dst->digits->size = size;
+    dst->is_negative = negative && (size > 1 || limbs[0] != 0);
+}
+
+static inline int fixed_compare(const Fixed* a, const Fixed* b) {
+    for (size_t i = FIXED_WORDS; i > 0; i--) {
+        if (a->w[i - 1] != b->w[i - 1]) {
+            return a->w[i - 1] > b->w[i - 1] ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+// r = a + b; false при переносе за 256 бит
+static inline bool fixed_add_abs(Fixed* r, const Fixed* a, const Fixed* b) {
+    u128 s;
+    s = (u128)a->w[0] + b->w[0];
+    r->w[0] = (uint64_t)s;
+    s = (u128)a->w[1] + b->w[1] + (uint64_t)(s >> 64);
+    r->w[1] = (uint64_t)s;
+    s = (u128)a->w[2] + b->w[2] + (uint64_t)(s >> 64);
+    r->w[2] = (uint64_t)s;
+    s = (u128)a->w[3] + b->w[3] + (uint64_t)(s >> 64);
+    r->w[3] = (uint64_t)s;
+    r->words = FIXED_WORDS;
+    return (s >> 64) == 0;
+}
+
+// r = a - b, где a >= b
+static inline void fixed_sub_abs(Fixed* r, const Fixed* a, const Fixed* b) {
+    u128 d;
+    d = (u128)a->w[0] - b->w[0];
+    r->w[0] = (uint64_t)d;
+    d = (u128)a->w[1] - b->w[1] - (uint64_t)(d >> 127);
+    r->w[1] = (uint64_t)d;
+    d = (u128)a->w[2] - b->w[2] - (uint64_t)(d >> 127);
+    r->w[2] = (uint64_t)d;
+    d = (u128)a->w[3] - b->w[3] - (uint64_t)(d >> 127);
+    r->w[3] = (uint64_t)d;
+    r->words = FIXED_WORDS;
+}
+
+// t += x * y + c; возвращает перенос
+static inline uint64_t fixed_mac(uint64_t* t, uint64_t x, uint64_t y, uint64_t c) {
+    u128 p = (u128)x * y + *t + c;
+    *t = (uint64_t)p;
+    return (uint64_t)(p >> 64);
+}
+
+// r = a * b; false, если произведение не меньше 2^256. Считаются только
+// десять произведений слов на позициях i + j < 4: остальные нулевые,
+// раз суммарная длина множителей не больше пяти слов.
+static inline bool fixed_mul_abs(Fixed* r, const Fixed* a, const Fixed* b) {
+    if (a->words + b->words > FIXED_WORDS + 1) return false;
+
+    const uint64_t* x = a->w;
+    const uint64_t* y = b->w;
+    uint64_t* t = r->w;
+    uint64_t c;
+    uint64_t overflow = 0;
+
+    t[0] = t[1] = t[2] = t[3] = 0;
+    c = fixed_mac(&t[0], x[0], y[0], 0);
+    c = fixed_mac(&t[1], x[0], y[1], c);
+    c = fixed_mac(&t[2], x[0], y[2], c);
+    overflow |= fixed_mac(&t[3], x[0], y[3], c);
+
+    c = fixed_mac(&t[1], x[1], y[0], 0);
+    c = fixed_mac(&t[2], x[1], y[1], c);
+    overflow |= fixed_mac(&t[3], x[1], y[2], c);
+
+    c = fixed_mac(&t[2], x[2], y[0], 0);
+    overflow |= fixed_mac(&t[3], x[2], y[1], c);
+
+    overflow |= fixed_mac(&t[3], x[3], y[0], 0);
+
+    r->words = FIXED_WORDS;
+    return overflow == 0;
+}
+
+bool bignum_fixed_add(BigNum* dst, const BigNum* a, const BigNum* b, bool b_negative) {
+    Fixed x, y, r;
+    if (!fixed_load(&x, a) || !fixed_load(&y, b)) return false;
+
+    bool negative = a->is_negative;
+    if (a->is_negative == b_negative) {
+        if (!fixed_add_abs(&r, &x, &y)) return false;
+    } else if (fixed_compare(&x, &y) >= 0) {
+        fixed_sub_abs(&r, &x, &y);
+    } else {
+        fixed_sub_abs(&r, &y, &x);
+        negative = b_negative;
+    }
+
+    fixed_store(dst, &r, negative);
+    return true;
+}
+
+bool bignum_fixed_mul(BigNum* dst, const BigNum* a, const BigNum* b) {
+    // Произведение занимает не меньше size_a + size_b - 1 разрядов: заведомо
+    // длинное не загружаем
+    if (a->digits->size + b->digits->size > FIXED_LIMBS + 1) return false;
+
+    Fixed x, y, r;
+    if (!fixed_load(&x, a) || !fixed_load(&y, b) || !fixed_mul_abs(&r, &x, &y)) {
+        return false;
+    }
+
+    fixed_store(dst, &r, a->is_negative != b->is_negative);
+    return true;
+}
+
+#else
+
+bool bignum_fixed_add(BigNum* dst, const BigNum* a, const BigNum* b, bool b_negative) {
+    (void)dst; (void)a; (void)b; (void)b_negative;
+    return false;
+}
+
+bool bignum_fixed_mul(BigNum* dst, const BigNum* a, const BigNum* b) {
+    (void)dst; (void)a; (void)b;
+    return false;
+}
+
+#endif
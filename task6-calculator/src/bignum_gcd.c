@@ -0,0 +1,432 @@
+#include "bignum_internal.h"
+#include <string.h>
+
+// НОД алгоритмом Лемера: несколько шагов Евклида угадываются по старшим
+// 62 битам чисел в машинных словах, а к самим числам вся пачка применяется
+// одним линейным сочетанием с коэффициентами до 32 бит. Для длинных чисел —
+// половинный НОД (half-GCD): матрица шагов, сокращающих пару вдвое,
+// рекурсивно ищется по старшим половинам и применяется быстрым умножением.
+//
+// Любая цепочка шагов — целочисленная матрица с определителем ±1, а такое
+// преобразование пары не меняет её НОД. Поэтому неточность матрицы, найденной
+// по старшим разрядам, сказывается только на скорости, но не на ответе.
+
+// С этой длины (в разрядах) пара сокращается половинным НОД, а не Лемером:
+// у половинного НОД большая константа, и выигрывает он только на длинных числах
+#define HGCD_THRESHOLD 4096
+
+// Внутри половинного НОД части короче этого сокращаются шагами Лемера
+#define HGCD_BASE_LIMBS 96
+
+// Матрица шагов: (a, b) до шагов = M · (a, b) после
+typedef struct {
+    BigNum* m[2][2];
+    BigNum* t[2];       // Рабочие числа умножения матриц; у малых матриц NULL
+    int det;            // ±1
+} Matrix;
+
+// Число из одного разряда со знаком на стеке, |value| < BASE
+static void small_init(BigNum* num, int64_t value) {
+    arraylist_init(&num->storage);
+    num->digits = &num->storage;
+    num->is_negative = value < 0;
+    arraylist_push(num->digits, (uint32_t)(value < 0 ? -value : value));
+}
+
+// Матрица из малых чисел на стеке (только правый множитель matrix_mul)
+static void small_matrix(Matrix* k, BigNum storage[4], int64_t k00, int64_t k01, int64_t k10,
+                         int64_t k11, int det) {
+    small_init(&storage[0], k00);
+    small_init(&storage[1], k01);
+    small_init(&storage[2], k10);
+    small_init(&storage[3], k11);
+    k->m[0][0] = &storage[0];
+    k->m[0][1] = &storage[1];
+    k->m[1][0] = &storage[2];
+    k->m[1][1] = &storage[3];
+    k->t[0] = k->t[1] = NULL;
+    k->det = det;
+}
+
+static void matrix_free(Matrix* m) {
+    bignum_free(m->m[0][0]);
+    bignum_free(m->m[0][1]);
+    bignum_free(m->m[1][0]);
+    bignum_free(m->m[1][1]);
+    bignum_free(m->t[0]);
+    bignum_free(m->t[1]);
+}
+
+// Единичная матрица
+static bool matrix_init(Matrix* m) {
+    m->m[0][0] = bignum_from_int(1);
+    m->m[0][1] = bignum_create();
+    m->m[1][0] = bignum_create();
+    m->m[1][1] = bignum_from_int(1);
+    m->t[0] = bignum_create();
+    m->t[1] = bignum_create();
+    m->det = 1;
+    if (!m->m[0][0] || !m->m[0][1] || !m->m[1][0] || !m->m[1][1] || !m->t[0] || !m->t[1]) {
+        matrix_free(m);
+        return false;
+    }
+    return true;
+}
+
+// m = m · k
+static bool matrix_mul(Matrix* m, const Matrix* k) {
+    BigNum* t0 = m->t[0];
+    BigNum* t1 = m->t[1];
+    for (int i = 0; i < 2; i++) {
+        BigNum* x = m->m[i][0];
+        BigNum* y = m->m[i][1];
+        // (x, y) = (x·k00 + y·k10, x·k01 + y·k11); новое x копится в t0
+        bool ok = bignum_multiply_into(t0, x, k->m[0][0]) &&
+                  bignum_multiply_into(t1, y, k->m[1][0]) && bignum_add_into(t0, t0, t1) &&
+                  bignum_multiply_into(t1, x, k->m[0][1]) &&
+                  bignum_multiply_into(y, y, k->m[1][1]) && bignum_add_into(y, y, t1);
+        if (!ok) return false;
+        m->m[i][0] = t0;
+        m->t[0] = t0 = x;
+    }
+    m->det *= k->det;
+    return true;
+}
+
+static void negate(BigNum* num) {
+    num->is_negative = !num->is_negative && !bignum_is_zero(num);
+}
+
+static void swap_nums(BigNum** a, BigNum** b) {
+    BigNum* t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Приводит пару к a >= b >= 0, меняя m (может быть NULL) так, чтобы
+// равенство «до = m · после» сохранилось
+static void normalize_pair(BigNum** a, BigNum** b, Matrix* m) {
+    for (int j = 0; j < 2; j++) {
+        BigNum* x = j == 0 ? *a : *b;
+        if (!x->is_negative) continue;
+        negate(x);
+        if (m) {
+            negate(m->m[0][j]);
+            negate(m->m[1][j]);
+            m->det = -m->det;
+        }
+    }
+    if (bignum_compare_abs(*a, *b) < 0) {
+        swap_nums(a, b);
+        if (m) {
+            swap_nums(&m->m[0][0], &m->m[0][1]);
+            swap_nums(&m->m[1][0], &m->m[1][1]);
+            m->det = -m->det;
+        }
+    }
+}
+
+// Шаг деления: (a, b) = (b, a mod b), m = m · [[q, 1], [1, 0]]
+static bool division_step(BigNum** a, BigNum** b, Matrix* m) {
+    BigNum* q = NULL;
+    BigNum* r = NULL;
+    bool ok = bignum_divmod(*a, *b, m ? &q : NULL, &r);
+    if (ok && m) {
+        BigNum storage[4];
+        Matrix k;
+        small_matrix(&k, storage, 0, 1, 1, 0, -1);
+        k.m[0][0] = q;
+        ok = matrix_mul(m, &k);
+    }
+    bignum_free(q);
+    if (!ok) {
+        bignum_free(r);
+        return false;
+    }
+    bignum_free(*a);
+    *a = *b;
+    *b = r;
+    return true;
+}
+
+// Старшие 62 бита окна разрядов x[n - 3 .. n) со сдвигом shift
+static uint64_t top_bits(const uint32_t* x, size_t n, int shift) {
+    uint64_t hi = (uint64_t)x[n - 1] << 32 | x[n - 2];
+    if (shift >= 32) {
+        return hi >> (shift - 32);
+    }
+    return hi << (32 - shift) | x[n - 3] >> shift;
+}
+
+// |x| + q·|y| <= UINT32_MAX: следующий коэффициент умещается в разряд
+static bool cofactor_fits(int64_t x, int64_t y, int64_t q) {
+    uint64_t ax = (uint64_t)(x < 0 ? -x : x);
+    uint64_t ay = (uint64_t)(y < 0 ? -y : y);
+    return ay == 0 ? q <= (int64_t)(UINT32_MAX - ax) : (uint64_t)q <= (UINT32_MAX - ax) / ay;
+}
+
+// r = x·a + y·b для n-разрядных a и b, x и y разных знаков (или ноль);
+// результат заранее известен неотрицательным и не длиннее n разрядов
+static bool combine(BigNum* r, const uint32_t* a, const uint32_t* b, size_t n, int64_t x,
+                    int64_t y) {
+    if (y > 0) {
+        const uint32_t* t = a;
+        a = b;
+        b = t;
+        int64_t s = x;
+        x = y;
+        y = s;
+    }
+
+    arraylist_resize(r->digits, n);
+    if (arraylist_size(r->digits) != n) return false;
+    limbs_mul_1(r->digits->data, a, n, (uint32_t)x);
+    limbs_submul_1(r->digits->data, b, n, (uint32_t)-y);
+    r->is_negative = false;
+    bignum_normalize(r);
+    return true;
+}
+
+// Шаг Лемера над a >= b > 0; ta и tb — рабочие числа (меняются местами с a и b).
+// Если по старшим битам не угадан ни один шаг, делается обычный шаг деления.
+static bool lehmer_step(BigNum** a, BigNum** b, BigNum** ta, BigNum** tb, Matrix* m) {
+    size_t n = arraylist_size((*a)->digits);
+    if (n < 3 || arraylist_size((*b)->digits) + 1 < n) {
+        return division_step(a, b, m);
+    }
+
+    // Разряды b дополняются нулями до длины a, чтобы окна совпадали
+    arraylist_resize((*b)->digits, n);
+    if (arraylist_size((*b)->digits) != n) return false;
+    const uint32_t* ad = (*a)->digits->data;
+    const uint32_t* bd = (*b)->digits->data;
+
+    // Сдвиг окна: число значащих бит старшего разряда плюс 2
+    int shift = 2;
+    for (uint32_t top = ad[n - 1]; top; top >>= 1) {
+        shift++;
+    }
+    int64_t x = (int64_t)top_bits(ad, n, shift);
+    int64_t y = (int64_t)top_bits(bd, n, shift);
+
+    // Алгоритм L Кнута: частное верно, если совпадает на обеих границах
+    // погрешности приближения
+    int64_t A = 1, B = 0, C = 0, D = 1;
+    int det = 1;
+    while (y + C > 0 && y + D > 0) {
+        int64_t q = (x + A) / (y + C);
+        if (q != (x + B) / (y + D) || !cofactor_fits(A, C, q) || !cofactor_fits(B, D, q)) {
+            break;
+        }
+        int64_t t = A - q * C;
+        A = C;
+        C = t;
+        t = B - q * D;
+        B = D;
+        D = t;
+        t = x - q * y;
+        x = y;
+        y = t;
+        det = -det;
+    }
+
+    if (B == 0) {
+        bignum_normalize(*b);
+        return division_step(a, b, m);
+    }
+
+    // (a, b) = (A·a + B·b, C·a + D·b); обратная матрица — det·[[D, -B], [-C, A]]
+    if (!combine(*ta, ad, bd, n, A, B) || !combine(*tb, ad, bd, n, C, D)) {
+        bignum_normalize(*b);
+        return false;
+    }
+    swap_nums(a, ta);
+    swap_nums(b, tb);
+
+    if (m) {
+        BigNum storage[4];
+        Matrix k;
+        small_matrix(&k, storage, det * D, -det * B, -det * C, det * A, det);
+        return matrix_mul(m, &k);
+    }
+    return true;
+}
+
+// Шаги Лемера, пока b длиннее s разрядов
+static bool lehmer_reduce(BigNum** a, BigNum** b, size_t s, Matrix* m) {
+    BigNum* ta = bignum_create();
+    BigNum* tb = bignum_create();
+    bool ok = ta && tb;
+    while (ok && !bignum_is_zero(*b) && arraylist_size((*b)->digits) > s) {
+        ok = lehmer_step(a, b, &ta, &tb, m);
+    }
+    bignum_free(ta);
+    bignum_free(tb);
+    return ok;
+}
+
+// (a, b) = m^(-1) · (a, b) = det·(m11·a - m01·b, m00·b - m10·a); знаки не приводятся
+static bool apply_inverse(BigNum** a, BigNum** b, const Matrix* m) {
+    BigNum* na = bignum_create();
+    BigNum* nb = bignum_create();
+    BigNum* t = bignum_create();
+    bool ok = na && nb && t && bignum_multiply_into(na, m->m[1][1], *a) &&
+              bignum_multiply_into(t, m->m[0][1], *b) && bignum_subtract_into(na, na, t) &&
+              bignum_multiply_into(nb, m->m[0][0], *b) &&
+              bignum_multiply_into(t, m->m[1][0], *a) && bignum_subtract_into(nb, nb, t);
+    bignum_free(t);
+    if (!ok) {
+        bignum_free(na);
+        bignum_free(nb);
+        return false;
+    }
+
+    if (m->det < 0) {
+        negate(na);
+        negate(nb);
+    }
+    bignum_free(*a);
+    bignum_free(*b);
+    *a = na;
+    *b = nb;
+    return true;
+}
+
+// x += high·BASE^p
+static bool add_shifted(BigNum* x, const BigNum* high, size_t p) {
+    size_t hn = arraylist_size(high->digits);
+    BigNum* t = bignum_create();
+    bool ok = t != NULL;
+    if (ok) {
+        arraylist_resize(t->digits, p + hn);
+        ok = arraylist_size(t->digits) == p + hn;
+    }
+    if (ok) {
+        memcpy(t->digits->data + p, high->digits->data, hn * sizeof(uint32_t));
+        t->is_negative = high->is_negative;
+        bignum_normalize(t);
+        ok = bignum_add_into(x, x, t);
+    }
+    bignum_free(t);
+    return ok;
+}
+
+// Матрица по старшим разрядам пары начиная с p-го, применённая к самой паре
+static bool reduce_high(BigNum** a, BigNum** b, size_t p, Matrix* m);
+
+// Половинный НОД: сокращает a >= b >= 0 (a из n разрядов), пока b длиннее
+// n/2 + 1 разрядов. m (может быть NULL) домножается на матрицу сделанных шагов.
+static bool hgcd(BigNum** a, BigNum** b, Matrix* m) {
+    size_t n = arraylist_size((*a)->digits);
+    size_t s = n / 2 + 1;
+    if (n < HGCD_BASE_LIMBS) {
+        return lehmer_reduce(a, b, s, m);
+    }
+
+    // Старшие n - n/2 разрядов сокращаются вдвое, пара — примерно до 3n/4
+    bool ok = arraylist_size((*b)->digits) <= s || reduce_high(a, b, n / 2, m);
+
+    // Шаг деления и вторая половина: старшая часть длины 2(n2 - s) сокращается
+    // до n2 - s разрядов, и пара доходит до s. Если первая половина не сократила
+    // пару (n2 > n), вторую пропускаем: рекурсия должна идти на меньших длинах.
+    if (ok && !bignum_is_zero(*b) && arraylist_size((*b)->digits) > s) {
+        ok = division_step(a, b, m);
+    }
+    if (ok && arraylist_size((*b)->digits) > s && arraylist_size((*a)->digits) <= n) {
+        ok = reduce_high(a, b, 2 * s - arraylist_size((*a)->digits), m);
+    }
+    return ok && lehmer_reduce(a, b, s, m);
+}
+
+static bool reduce_high(BigNum** a, BigNum** b, size_t p, Matrix* m) {
+    size_t an = arraylist_size((*a)->digits);
+    size_t bn = arraylist_size((*b)->digits);
+    if (bn <= p) return true;
+
+    Matrix h;
+    if (!matrix_init(&h)) return false;
+    BigNum* ah = bignum_from_limbs((*a)->digits->data + p, an - p);
+    BigNum* bh = bignum_from_limbs((*b)->digits->data + p, bn - p);
+    bool ok = ah && bh && hgcd(&ah, &bh, &h);
+
+    // Старшие части рекурсия уже сократила: h^(-1)·(a, b) = h^(-1)·(младшие
+    // p разрядов) + (ah, bh)·BASE^p, так что умножать нужно только младшие части
+    if (ok) {
+        arraylist_resize((*a)->digits, p);
+        arraylist_resize((*b)->digits, p);
+        bignum_normalize(*a);
+        bignum_normalize(*b);
+        ok = apply_inverse(a, b, &h) && add_shifted(*a, ah, p) && add_shifted(*b, bh, p);
+    }
+    if (ok) {
+        normalize_pair(a, b, &h);
+        ok = !m || matrix_mul(m, &h);
+    }
+    bignum_free(ah);
+    bignum_free(bh);
+    matrix_free(&h);
+    return ok;
+}
+
+// НОД двух чисел не длиннее двух разрядов
+static uint64_t gcd_u64(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+bool bignum_gcd_into(BigNum* dst, const BigNum* x, const BigNum* y) {
+    BigNum* a = bignum_clone(x);
+    BigNum* b = bignum_clone(y);
+    BigNum* ta = bignum_create();
+    BigNum* tb = bignum_create();
+    bool ok = a && b && ta && tb;
+    bool stalled = false;
+    if (ok) {
+        normalize_pair(&a, &b, NULL);
+    }
+
+    while (ok && !bignum_is_zero(b)) {
+        size_t an = arraylist_size(a->digits);
+        if (an <= 2) {
+            uint64_t u, v;
+            bignum_to_uint64(a, &u);
+            bignum_to_uint64(b, &v);
+            uint64_t g = gcd_u64(u, v);
+            uint32_t limbs[2] = { (uint32_t)g, (uint32_t)(g >> 32) };
+            ok = bignum_replace(&a, bignum_from_limbs(limbs, 2));
+            break;
+        }
+        if (arraylist_size(b->digits) + 1 < an) {
+            // Длинное частное: одно деление выгоднее шагов Лемера
+            ok = division_step(&a, &b, NULL);
+        } else if (an >= HGCD_THRESHOLD && !stalled) {
+            ok = hgcd(&a, &b, NULL);
+            // Матрица по старшим разрядам могла не сократить пару: тогда
+            // следующий проход идёт точными шагами Лемера
+            stalled = arraylist_size(a->digits) >= an;
+        } else {
+            ok = lehmer_step(&a, &b, &ta, &tb, NULL);
+            stalled = false;
+        }
+    }
+
+    ok = ok && bignum_assign(dst, a);
+    bignum_free(a);
+    bignum_free(b);
+    bignum_free(ta);
+    bignum_free(tb);
+    return ok;
+}
+
+BigNum* bignum_gcd(const BigNum* a, const BigNum* b) {
+    BigNum* result = bignum_create();
+    if (result && !bignum_gcd_into(result, a, b)) {
+        bignum_free(result);
+        return NULL;
+    }
+    return result;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "alloc_stats.h"
+#include "bignum.h"
+#include "threadpool.h"
+
+// Внутренние функции BigNum, общие для нескольких единиц трансляции.
+// Работают с «сырыми» массивами разрядов (младшие разряды в начале).
+
+// Десятичные группы для разбора и печати: по 9 цифр, основание 10^9
+#define DECIMAL_GROUP_BASE 1000000000u
+#define DECIMAL_GROUP_DIGITS 9
+
+// Ядра над n разрядами без проверок границ (bignum_limbs.c). r может совпадать
+// с любым из входов. Возвращают перенос (заём) из старшего разряда.
+uint32_t limbs_add_n(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n);
+uint32_t limbs_sub_n(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n);
+// r = a + c и r = a - c для одного разряда c
+uint32_t limbs_add_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t c);
+uint32_t limbs_sub_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t c);
+// r = a * m; r += a * m; r -= a * m. Возвращают старший разряд (заём).
+uint32_t limbs_mul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t m);
+uint32_t limbs_addmul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t m);
+uint32_t limbs_submul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t m);
+
+// Быстрый путь для чисел до 256 бит (bignum_fixed.c): dst = a + (b со знаком
+// b_negative) и dst = a * b без выделений памяти. Возвращают false, ничего
+// не меняя, если операнд или результат длиннее 256 бит — тогда нужен общий путь.
+// dst может совпадать с a и b.
+bool bignum_fixed_add(BigNum* dst, const BigNum* a, const BigNum* b, bool b_negative);
+bool bignum_fixed_mul(BigNum* dst, const BigNum* a, const BigNum* b);
+
+// Нормализованный BigNum из count разрядов limbs
+BigNum* bignum_from_limbs(const uint32_t* limbs, size_t count);
+
+// Деление модуля на маленькое число на месте. Возвращает остаток.
+uint32_t bignum_div_small(BigNum* num, uint32_t divisor);
+
+// Заменяет *dst на fresh, освобождая старое значение. Возвращает fresh != NULL,
+// что позволяет строить цепочки ok = ok && bignum_replace(...)
+bool bignum_replace(BigNum** dst, BigNum* fresh);
+
+// r[0 .. an + bn) = a * b. Буфер r не должен пересекаться с a и b.
+// Возвращает false при нехватке памяти.
+bool bignum_mul_limbs(uint32_t* r, const uint32_t* a, size_t an,
+                      const uint32_t* b, size_t bn);
+
+// Умножение через NTT по трём простым модулям. Возвращает false, если
+// an + bn больше bignum_ntt_max_limbs() или не хватило памяти.
+// С пулом (не NULL) преобразования и восстановление делятся между потоками.
+bool bignum_mul_ntt(uint32_t* r, const uint32_t* a, size_t an,
+                    const uint32_t* b, size_t bn, ThreadPool* pool);
+size_t bignum_ntt_max_limbs(void);
+
+// Обратное число inv = floor(BASE^(2n) / d) для d из n разрядов (метод Ньютона)
+BigNum* bignum_reciprocal(const BigNum* d);
+
+// Деление неотрицательного x < BASE^(2n) на d по заранее посчитанному
+// inv = bignum_reciprocal(d): два умножения вместо полного деления
+bool bignum_divmod_reciprocal(const BigNum* x, const BigNum* d, const BigNum* inv,
+                              BigNum** quotient, BigNum** remainder);
+
+// Перевод десятичных групп (младшие в начале) в BigNum и обратно.
+// bignum_set_decimal_groups записывает модуль в dst, не трогая знак.
+// bignum_to_decimal_groups возвращает массив из malloc (без ведущих нулевых
+// групп, минимум одна) и игнорирует знак.
+bool bignum_set_decimal_groups(BigNum* dst, const uint32_t* groups, size_t count);
+uint32_t* bignum_to_decimal_groups(const BigNum* num, size_t* count);
+
+// Запись десятичной группы (bignum.c): ровно 9 цифр с ведущими нулями и без
+// них (возвращает число записанных цифр)
+void bignum_format_group(char* p, uint32_t value);
+size_t bignum_format_group_head(char* p, uint32_t value);
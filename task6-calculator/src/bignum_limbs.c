@@ -0,0 +1,153 @@
+#include "bignum_internal.h"
+#include <string.h>
+
+// Базовые ядра над массивами разрядов без проверок границ.
+//
+// Где есть 128-битная арифметика, пары соседних 32-битных разрядов
+// обрабатываются как одно 64-битное слово (разряды лежат в памяти младшими
+// вперёд, что совпадает с little-endian): цепочка переносов вдвое короче.
+// Иначе — переносимый вариант с 64-битными промежуточными значениями.
+
+#if defined(__SIZEOF_INT128__) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LIMBS_WIDE 1
+typedef unsigned __int128 wide_t;
+
+static inline uint64_t load2(const uint32_t* p) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+static inline void store2(uint32_t* p, uint64_t x) {
+    memcpy(p, &x, sizeof(x));
+}
+#endif
+
+uint32_t limbs_add_n(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n) {
+    size_t i = 0;
+#ifdef LIMBS_WIDE
+    wide_t wcarry = 0;
+    for (; i + 2 <= n; i += 2) {
+        wide_t sum = (wide_t)load2(a + i) + load2(b + i) + wcarry;
+        store2(r + i, (uint64_t)sum);
+        wcarry = sum >> 64;
+    }
+    uint64_t carry = (uint64_t)wcarry;
+#else
+    uint64_t carry = 0;
+#endif
+    for (; i < n; i++) {
+        uint64_t sum = (uint64_t)a[i] + b[i] + carry;
+        r[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    return (uint32_t)carry;
+}
+
+uint32_t limbs_sub_n(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n) {
+    size_t i = 0;
+#ifdef LIMBS_WIDE
+    // Заём — старший бит разности в 128 битах
+    wide_t wborrow = 0;
+    for (; i + 2 <= n; i += 2) {
+        wide_t diff = (wide_t)load2(a + i) - load2(b + i) - wborrow;
+        store2(r + i, (uint64_t)diff);
+        wborrow = diff >> 127;
+    }
+    uint64_t borrow = (uint64_t)wborrow;
+#else
+    uint64_t borrow = 0;
+#endif
+    for (; i < n; i++) {
+        uint64_t diff = (uint64_t)a[i] - b[i] - borrow;
+        r[i] = (uint32_t)diff;
+        borrow = diff >> 63;
+    }
+    return (uint32_t)borrow;
+}
+
+uint32_t limbs_add_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t c) {
+    size_t i = 0;
+    for (; c && i < n; i++) {
+        uint64_t sum = (uint64_t)a[i] + c;
+        r[i] = (uint32_t)sum;
+        c = (uint32_t)(sum >> 32);
+    }
+    if (r != a && i < n) {
+        memcpy(r + i, a + i, (n - i) * sizeof(uint32_t));
+    }
+    return c;
+}
+
+uint32_t limbs_sub_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t c) {
+    size_t i = 0;
+    for (; c && i < n; i++) {
+        uint64_t diff = (uint64_t)a[i] - c;
+        r[i] = (uint32_t)diff;
+        c = (uint32_t)(diff >> 63);
+    }
+    if (r != a && i < n) {
+        memcpy(r + i, a + i, (n - i) * sizeof(uint32_t));
+    }
+    return c;
+}
+
+uint32_t limbs_mul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t m) {
+    size_t i = 0;
+    uint64_t carry = 0;
+#ifdef LIMBS_WIDE
+    for (; i + 2 <= n; i += 2) {
+        wide_t prod = (wide_t)load2(a + i) * m + carry;
+        store2(r + i, (uint64_t)prod);
+        carry = (uint64_t)(prod >> 64);
+    }
+#endif
+    for (; i < n; i++) {
+        uint64_t prod = (uint64_t)a[i] * m + carry;
+        r[i] = (uint32_t)prod;
+        carry = prod >> 32;
+    }
+    return (uint32_t)carry;
+}
+
+uint32_t limbs_addmul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t m) {
+    size_t i = 0;
+    uint64_t carry = 0;
+#ifdef LIMBS_WIDE
+    for (; i + 2 <= n; i += 2) {
+        wide_t prod = (wide_t)load2(a + i) * m + load2(r + i) + carry;
+        store2(r + i, (uint64_t)prod);
+        carry = (uint64_t)(prod >> 64);
+    }
+#endif
+    for (; i < n; i++) {
+        // (2^32 - 1)^2 + 2 * (2^32 - 1) < 2^64: переполнения нет
+        uint64_t prod = (uint64_t)a[i] * m + r[i] + carry;
+        r[i] = (uint32_t)prod;
+        carry = prod >> 32;
+    }
+    return (uint32_t)carry;
+}
+
+uint32_t limbs_submul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t m) {
+    size_t i = 0;
+    uint64_t carry = 0;
+#ifdef LIMBS_WIDE
+    for (; i + 2 <= n; i += 2) {
+        wide_t prod = (wide_t)load2(a + i) * m + carry;
+        uint64_t x = load2(r + i);
+        uint64_t lo = (uint64_t)prod;
+        store2(r + i, x - lo);
+        carry = (uint64_t)(prod >> 64) + (x < lo);
+    }
+#endif
+    for (; i < n; i++) {
+        uint64_t prod = (uint64_t)a[i] * m + carry;
+        uint32_t x = r[i];
+        uint32_t lo = (uint32_t)prod;
+        r[i] = x - lo;
+        carry = (prod >> 32) + (x < lo);
+    }
+    return (uint32_t)carry;
+}
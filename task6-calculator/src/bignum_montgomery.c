@@ -0,0 +1,294 @@
+#include "bignum_internal.h"
+#include <string.h>
+
+// Арифметика по модулю m. Для нечётного m значения хранятся в форме
+// Монтгомери x·R mod m, R = BASE^n (n — длина m в разрядах): произведение
+// сокращается делением на R, то есть сдвигом, без деления на m. Сложение
+// и вычитание в этой форме не отличаются от обычных. Для чётного m форма
+// совпадает с обычным вычетом, а произведение сокращается делением.
+
+// С этой длины модуля сокращение Монтгомери идёт двумя умножениями
+// (быстрыми алгоритмами), а не построчно за n^2
+#define REDC_MUL_THRESHOLD 48
+
+// Рабочий буфер произведения до этой длины модуля лежит на стеке
+#define MONT_STACK_LIMBS 32
+
+struct BigNumModulus {
+    BigNum* m;
+    size_t n;
+    bool montgomery;        // m нечётный
+    uint32_t m_word;        // -m^(-1) mod BASE
+    uint32_t* m_inv;        // -m^(-1) mod R, только при n >= REDC_MUL_THRESHOLD
+    BigNum* r2;             // R^2 mod m: множитель перевода в форму Монтгомери
+    BigNum* one;            // Единица во внутренней форме
+};
+
+static int limbs_cmp(const uint32_t* a, const uint32_t* b, size_t n) {
+    for (size_t i = n; i > 0; i--) {
+        if (a[i - 1] != b[i - 1]) {
+            return a[i - 1] > b[i - 1] ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+// Младшие n разрядов произведения двух n-разрядных чисел
+static bool mul_low(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n) {
+    uint32_t* full = (uint32_t*)counted_malloc(2 * n * sizeof(uint32_t));
+    if (!full || !bignum_mul_limbs(full, a, n, b, n)) {
+        free(full);
+        return false;
+    }
+    memcpy(r, full, n * sizeof(uint32_t));
+    free(full);
+    return true;
+}
+
+// -m^(-1) mod BASE^n итерацией Ньютона y = y·(2 + m·y), удваивающей точность
+static uint32_t* negated_inverse(const uint32_t* m, size_t n, uint32_t m_word) {
+    uint32_t* y = (uint32_t*)counted_malloc(3 * n * sizeof(uint32_t));
+    if (!y) return NULL;
+    uint32_t* t = y + n;
+    uint32_t* u = t + n;
+
+    memset(y, 0, n * sizeof(uint32_t));
+    y[0] = m_word;
+    for (size_t k = 1; k < n;) {
+        k = 2 * k < n ? 2 * k : n;
+        if (!mul_low(t, m, y, k)) {
+            free(y);
+            return NULL;
+        }
+        limbs_add_1(t, t, k, 2);
+        if (!mul_low(u, y, t, k)) {
+            free(y);
+            return NULL;
+        }
+        memcpy(y, u, k * sizeof(uint32_t));
+    }
+    return y;
+}
+
+// Сокращение Монтгомери: t (2n + 1 разрядов, t < m·R) -> t·R^(-1) mod m в t[n .. 2n)
+static bool redc(const BigNumModulus* mod, uint32_t* t) {
+    size_t n = mod->n;
+    const uint32_t* m = mod->m->digits->data;
+
+    if (n < REDC_MUL_THRESHOLD) {
+        for (size_t i = 0; i < n; i++) {
+            uint32_t u = t[i] * mod->m_word;
+            uint32_t carry = limbs_addmul_1(t + i, m, n, u);
+            limbs_add_1(t + i + n, t + i + n, n + 1 - i, carry);
+        }
+    } else {
+        // u = t·(-m^(-1)) mod R, затем t + u·m делится на R нацело
+        uint32_t* u = (uint32_t*)counted_malloc(3 * n * sizeof(uint32_t));
+        if (!u) return false;
+        uint32_t* um = u + n;
+        bool ok = mul_low(u, t, mod->m_inv, n) && bignum_mul_limbs(um, u, n, m, n);
+        if (ok) {
+            t[2 * n] += limbs_add_n(t, t, um, 2 * n);
+        }
+        free(u);
+        if (!ok) return false;
+    }
+
+    // Результат меньше 2m: достаточно одного вычитания
+    uint32_t* r = t + n;
+    if (r[n] != 0 || limbs_cmp(r, m, n) >= 0) {
+        r[n] -= limbs_sub_n(r, r, m, n);
+    }
+    return true;
+}
+
+// Записывает n разрядов limbs в dst как неотрицательное число
+static bool store_limbs(BigNum* dst, const uint32_t* limbs, size_t n) {
+    arraylist_resize(dst->digits, n);
+    if (arraylist_size(dst->digits) != n) return false;
+    memcpy(dst->digits->data, limbs, n * sizeof(uint32_t));
+    dst->is_negative = false;
+    bignum_normalize(dst);
+    return true;
+}
+
+// dst = a·b·R^(-1) mod m для a, b из [0, m)
+static bool mont_mul(const BigNumModulus* mod, BigNum* dst, const BigNum* a, const BigNum* b) {
+    size_t n = mod->n;
+    size_t an = arraylist_size(a->digits);
+    size_t bn = arraylist_size(b->digits);
+
+    uint32_t local[2 * MONT_STACK_LIMBS + 1];
+    uint32_t* t = n <= MONT_STACK_LIMBS ? local
+                                        : (uint32_t*)counted_malloc((2 * n + 1) * sizeof(uint32_t));
+    if (!t) return false;
+
+    memset(t + an + bn, 0, (2 * n + 1 - an - bn) * sizeof(uint32_t));
+    bool ok = bignum_mul_limbs(t, a->digits->data, an, b->digits->data, bn) && redc(mod, t) &&
+              store_limbs(dst, t + n, n);
+
+    if (t != local) free(t);
+    return ok;
+}
+
+// dst = a mod m в [0, m) для любого a
+static bool reduce(const BigNumModulus* mod, BigNum* dst, const BigNum* a) {
+    if (!a->is_negative && bignum_compare_abs(a, mod->m) < 0) {
+        return dst == a || bignum_assign(dst, a);
+    }
+
+    BigNum* r = NULL;
+    bool ok = bignum_divmod(a, mod->m, NULL, &r);
+    if (ok && r->is_negative) {
+        ok = bignum_add_into(r, r, mod->m);
+    }
+    ok = ok && bignum_assign(dst, r);
+    bignum_free(r);
+    return ok;
+}
+
+BigNumModulus* bignum_modulus_create(const BigNum* m) {
+    if (!m || m->is_negative || bignum_is_zero(m)) return NULL;
+
+    BigNumModulus* mod = (BigNumModulus*)counted_calloc(1, sizeof(BigNumModulus));
+    if (!mod) return NULL;
+
+    mod->m = bignum_clone(m);
+    mod->one = bignum_from_int(1);
+    if (!mod->m || !mod->one) {
+        bignum_modulus_free(mod);
+        return NULL;
+    }
+    mod->n = arraylist_size(m->digits);
+    const uint32_t* d = mod->m->digits->data;
+    mod->montgomery = d[0] & 1;
+    if (!mod->montgomery) {
+        return mod;
+    }
+
+    // m^(-1) mod BASE методом Ньютона: каждая итерация удваивает число верных бит
+    uint32_t inv = d[0];
+    for (int i = 0; i < 4; i++) {
+        inv *= 2 - d[0] * inv;
+    }
+    mod->m_word = -inv;
+
+    if (mod->n >= REDC_MUL_THRESHOLD &&
+        !(mod->m_inv = negated_inverse(d, mod->n, mod->m_word))) {
+        bignum_modulus_free(mod);
+        return NULL;
+    }
+
+    // R^2 mod m — одно деление при создании; единица в форме Монтгомери — R mod m
+    BigNum* r2 = bignum_create();
+    bool ok = r2 != NULL;
+    if (ok) {
+        arraylist_resize(r2->digits, 2 * mod->n + 1);
+        ok = arraylist_size(r2->digits) == 2 * mod->n + 1;
+    }
+    if (ok) {
+        r2->digits->data[2 * mod->n] = 1;
+        ok = reduce(mod, r2, r2) && (mod->r2 = bignum_clone(r2)) &&
+             mont_mul(mod, mod->one, mod->one, mod->r2);
+    }
+    bignum_free(r2);
+    if (!ok) {
+        bignum_modulus_free(mod);
+        return NULL;
+    }
+    return mod;
+}
+
+void bignum_modulus_free(BigNumModulus* mod) {
+    if (!mod) return;
+    bignum_free(mod->m);
+    bignum_free(mod->r2);
+    bignum_free(mod->one);
+    free(mod->m_inv);
+    free(mod);
+}
+
+const BigNum* bignum_modulus_value(const BigNumModulus* mod) {
+    return mod->m;
+}
+
+bool bignum_mod_enter(const BigNumModulus* mod, BigNum* dst, const BigNum* a) {
+    if (!reduce(mod, dst, a)) return false;
+    return !mod->montgomery || mont_mul(mod, dst, dst, mod->r2);
+}
+
+bool bignum_mod_leave(const BigNumModulus* mod, BigNum* dst, const BigNum* a) {
+    if (!mod->montgomery) {
+        return dst == a || bignum_assign(dst, a);
+    }
+
+    // Умножение на обычную единицу снимает множитель R
+    BigNum one;
+    arraylist_init(&one.storage);
+    one.digits = &one.storage;
+    one.is_negative = false;
+    arraylist_push(one.digits, 1);
+    return mont_mul(mod, dst, a, &one);
+}
+
+bool bignum_mod_add_into(const BigNumModulus* mod, BigNum* dst, const BigNum* a,
+                         const BigNum* b) {
+    if (!bignum_add_into(dst, a, b)) return false;
+    if (bignum_compare_abs(dst, mod->m) >= 0) {
+        return bignum_subtract_into(dst, dst, mod->m);
+    }
+    return true;
+}
+
+bool bignum_mod_subtract_into(const BigNumModulus* mod, BigNum* dst, const BigNum* a,
+                              const BigNum* b) {
+    if (!bignum_subtract_into(dst, a, b)) return false;
+    if (dst->is_negative) {
+        return bignum_add_into(dst, dst, mod->m);
+    }
+    return true;
+}
+
+bool bignum_mod_multiply_into(const BigNumModulus* mod, BigNum* dst, const BigNum* a,
+                              const BigNum* b) {
+    if (mod->montgomery) {
+        return mont_mul(mod, dst, a, b);
+    }
+    return bignum_multiply_into(dst, a, b) && reduce(mod, dst, dst);
+}
+
+bool bignum_mod_pow_into(const BigNumModulus* mod, BigNum* dst, const BigNum* base,
+                         const BigNum* exponent) {
+    if (exponent->is_negative) return false;
+
+    if (bignum_is_zero(exponent)) {
+        return bignum_assign(dst, mod->one);
+    }
+
+    // Основание копируется: dst может совпадать с base
+    BigNum* b = bignum_clone(base);
+    BigNum* result = bignum_clone(base);
+    bool ok = b && result;
+
+    // Двоичное возведение слева направо, начиная со следующего за старшим
+    // единичным битом показателя
+    size_t size = arraylist_size(exponent->digits);
+    const uint32_t* e = exponent->digits->data;
+    int bit = 31;
+    while (!(e[size - 1] >> bit & 1)) {
+        bit--;
+    }
+    for (size_t i = size; ok && i > 0; i--, bit = 32) {
+        while (ok && --bit >= 0) {
+            ok = bignum_mod_multiply_into(mod, result, result, result);
+            if (ok && (e[i - 1] >> bit & 1)) {
+                ok = bignum_mod_multiply_into(mod, result, result, b);
+            }
+        }
+    }
+
+    ok = ok && bignum_assign(dst, result);
+    bignum_free(b);
+    bignum_free(result);
+    return ok;
+}
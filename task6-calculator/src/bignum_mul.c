@@ -0,0 +1,283 @@
+#include "bignum_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Пороги переключения алгоритмов (в разрядах меньшего множителя).
+// Значения по умолчанию подобраны замером bignum_bench на x86-64 для разрядов
+// по 32 бита: Карацуба обгоняет школьное умножение с ~40 разрядов, Тоом-3
+// Карацубу — с ~1000, NTT Тоом-3 — с ~8000 (у NTT время растёт ступенями
+// на степенях двойки, порог взят посередине ступени).
+static BigNumMulThresholds thresholds = {
+    .karatsuba = 40,
+    .toom3 = 1000,
+    .ntt = 8000,
+    .parallel = 16384,
+};
+
+// Пул для параллельного NTT; NULL, пока потоки не включены
+static ThreadPool* mul_pool = NULL;
+
+void bignum_set_mul_thresholds(const BigNumMulThresholds* t) {
+    if (!t) return;
+
+    // Карацуба на совсем коротких числах не сходится; порядок школьное <
+    // Карацуба < Тоом-3 < NTT сохраняется
+    thresholds.karatsuba = t->karatsuba < 4 ? 4 : t->karatsuba;
+    thresholds.toom3 = t->toom3 < thresholds.karatsuba ? thresholds.karatsuba : t->toom3;
+    thresholds.ntt = t->ntt < thresholds.toom3 ? thresholds.toom3 : t->ntt;
+    thresholds.parallel = t->parallel < thresholds.ntt ? thresholds.ntt : t->parallel;
+}
+
+BigNumMulThresholds bignum_get_mul_thresholds(void) {
+    return thresholds;
+}
+
+bool bignum_set_threads(size_t threads) {
+    threadpool_destroy(mul_pool);
+    mul_pool = NULL;
+    if (threads <= 1) return true;
+
+    mul_pool = threadpool_create(threads);
+    return mul_pool != NULL;
+}
+
+size_t bignum_get_threads(void) {
+    return threadpool_size(mul_pool);
+}
+
+// r[0 .. an) = a + b, где an >= bn. r может совпадать с a. Возвращает перенос.
+static uint32_t limbs_add(uint32_t* r, const uint32_t* a, size_t an,
+                          const uint32_t* b, size_t bn) {
+    uint32_t carry = limbs_add_n(r, a, b, bn);
+    return limbs_add_1(r + bn, a + bn, an - bn, carry);
+}
+
+// r[0 .. rn) += v[0 .. vn), где rn >= vn. Перенос за пределы r отбрасывается.
+static void limbs_add_in(uint32_t* r, size_t rn, const uint32_t* v, size_t vn) {
+    uint32_t carry = limbs_add_n(r, r, v, vn);
+    limbs_add_1(r + vn, r + vn, rn - vn, carry);
+}
+
+// r[0 .. rn) -= v[0 .. vn), где r >= v.
+static void limbs_sub_in(uint32_t* r, size_t rn, const uint32_t* v, size_t vn) {
+    uint32_t borrow = limbs_sub_n(r, r, v, vn);
+    limbs_sub_1(r + vn, r + vn, rn - vn, borrow);
+}
+
+// Школьное умножение, O(an * bn): по строке addmul_1 на каждый разряд b
+static void mul_basecase(uint32_t* r, const uint32_t* a, size_t an,
+                         const uint32_t* b, size_t bn) {
+    r[an] = limbs_mul_1(r, a, an, b[0]);
+    for (size_t i = 1; i < bn; i++) {
+        r[i + an] = b[i] ? limbs_addmul_1(r + i, a, an, b[i]) : 0;
+    }
+}
+
+// Школьное возведение в квадрат: каждое произведение a[i] * a[j], i < j, считается
+// один раз и удваивается, затем добавляются квадраты a[i]^2 — вдвое меньше умножений
+static void sqr_basecase(uint32_t* r, const uint32_t* a, size_t n) {
+    r[0] = 0;
+    r[n] = limbs_mul_1(r + 1, a + 1, n - 1, a[0]);
+    for (size_t i = 1; i < n; i++) {
+        r[i + n] = limbs_addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+
+    // Удвоенная сумма попарных произведений меньше a^2, переноса наружу нет
+    limbs_add_n(r, r, r, 2 * n);
+
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t sq = (uint64_t)a[i] * a[i];
+        uint64_t lo = (uint64_t)r[2 * i] + (uint32_t)sq + carry;
+        uint64_t hi = (uint64_t)r[2 * i + 1] + (sq >> 32) + (lo >> 32);
+        r[2 * i] = (uint32_t)lo;
+        r[2 * i + 1] = (uint32_t)hi;
+        carry = hi >> 32;
+    }
+}
+
+// an >= 2 * bn: режем a на куски длины bn, чтобы быстрые алгоритмы работали
+// на сбалансированных множителях
+static bool mul_unbalanced(uint32_t* r, const uint32_t* a, size_t an,
+                           const uint32_t* b, size_t bn) {
+    uint32_t* t = (uint32_t*)counted_malloc(2 * bn * sizeof(uint32_t));
+    if (!t) return false;
+
+    memset(r, 0, (an + bn) * sizeof(uint32_t));
+
+    for (size_t i = 0; i < an; i += bn) {
+        size_t chunk = an - i < bn ? an - i : bn;
+        if (!bignum_mul_limbs(t, a + i, chunk, b, bn)) {
+            free(t);
+            return false;
+        }
+        limbs_add_in(r + i, an + bn - i, t, chunk + bn);
+    }
+
+    free(t);
+    return true;
+}
+
+// Карацуба: a = a1*B^m + a0, b = b1*B^m + b0,
+// a*b = z2*B^2m + ((a0+a1)(b0+b1) - z0 - z2)*B^m + z0
+static bool mul_karatsuba(uint32_t* r, const uint32_t* a, size_t an,
+                          const uint32_t* b, size_t bn) {
+    size_t m = (an + 1) / 2;
+    size_t a1n = an - m;
+    size_t b1n = bn - m;
+
+    uint32_t* tmp = (uint32_t*)counted_malloc((4 * m + 4) * sizeof(uint32_t));
+    if (!tmp) return false;
+
+    uint32_t* sa = tmp;
+    uint32_t* sb = tmp + m + 1;
+    uint32_t* t = tmp + 2 * m + 2;
+
+    // При возведении в квадрат (a == b) все три произведения — тоже квадраты
+    sa[m] = limbs_add(sa, a, m, a + m, a1n);
+    if (a == b) {
+        sb = sa;
+    } else {
+        sb[m] = limbs_add(sb, b, m, b + m, b1n);
+    }
+
+    if (!bignum_mul_limbs(r, a, m, b, m) ||
+        !bignum_mul_limbs(r + 2 * m, a + m, a1n, b + m, b1n) ||
+        !bignum_mul_limbs(t, sa, m + 1, sb, m + 1)) {
+        free(tmp);
+        return false;
+    }
+
+    size_t tn = 2 * m + 2;
+    limbs_sub_in(t, tn, r, 2 * m);
+    limbs_sub_in(t, tn, r + 2 * m, a1n + b1n);
+
+    while (tn > 0 && t[tn - 1] == 0) {
+        tn--;
+    }
+    limbs_add_in(r + m, an + bn - m, t, tn);
+
+    free(tmp);
+    return true;
+}
+
+// Нормализованный BigNum из p[from .. to), обрезанного по длине n
+static BigNum* limbs_slice(const uint32_t* p, size_t n, size_t from, size_t to) {
+    if (to > n) to = n;
+    return from < to ? bignum_from_limbs(p + from, to - from) : bignum_from_limbs(p, 0);
+}
+
+// Значения многочлена x2*t^2 + x1*t + x0 в точках 0, 1, -1, -2, бесконечность
+static bool toom3_evaluate(const uint32_t* p, size_t n, size_t k, BigNum* out[5]) {
+    BigNum* x0 = limbs_slice(p, n, 0, k);
+    BigNum* x1 = limbs_slice(p, n, k, 2 * k);
+    BigNum* x2 = limbs_slice(p, n, 2 * k, n);
+    BigNum* t = NULL;
+    bool ok = x0 && x1 && x2;
+
+    ok = ok && bignum_replace(&t, bignum_add(x0, x2));
+    ok = ok && (out[1] = bignum_add(t, x1)) != NULL;
+    ok = ok && (out[2] = bignum_subtract(t, x1)) != NULL;
+    ok = ok && bignum_replace(&t, bignum_add(out[2], x2));
+    ok = ok && bignum_replace(&t, bignum_add(t, t));
+    ok = ok && (out[3] = bignum_subtract(t, x0)) != NULL;
+
+    out[0] = x0;
+    out[4] = x2;
+    bignum_free(x1);
+    bignum_free(t);
+    return ok;
+}
+
+// Тоом-3 (последовательность интерполяции Бодрато)
+static bool mul_toom3(uint32_t* r, const uint32_t* a, size_t an,
+                      const uint32_t* b, size_t bn) {
+    size_t k = (an + 2) / 3;
+    BigNum* pa[5] = {NULL};
+    BigNum* pb[5] = {NULL};
+    BigNum* w[5] = {NULL};
+    BigNum* t = NULL;
+
+    // Для квадрата значения в точках общие, и пять произведений — квадраты
+    bool square = a == b;
+    bool ok = toom3_evaluate(a, an, k, pa) && (square || toom3_evaluate(b, bn, k, pb));
+    for (int i = 0; ok && i < 5; i++) {
+        ok = (w[i] = bignum_multiply(pa[i], square ? pa[i] : pb[i])) != NULL;
+    }
+
+    // w: r(0), r(1), r(-1), r(-2), r(inf) -> коэффициенты произведения
+    if (ok) {
+        ok = bignum_replace(&w[3], bignum_subtract(w[3], w[1]));
+        if (ok) bignum_div_small(w[3], 3);
+        ok = ok && bignum_replace(&w[1], bignum_subtract(w[1], w[2]));
+        if (ok) bignum_div_small(w[1], 2);
+        ok = ok && bignum_replace(&w[2], bignum_subtract(w[2], w[0]));
+        ok = ok && bignum_replace(&w[3], bignum_subtract(w[2], w[3]));
+        if (ok) bignum_div_small(w[3], 2);
+        ok = ok && bignum_replace(&t, bignum_add(w[4], w[4]));
+        ok = ok && bignum_replace(&w[3], bignum_add(w[3], t));
+        ok = ok && bignum_replace(&w[2], bignum_add(w[2], w[1]));
+        ok = ok && bignum_replace(&w[2], bignum_subtract(w[2], w[4]));
+        ok = ok && bignum_replace(&w[1], bignum_subtract(w[1], w[3]));
+    }
+
+    if (ok) {
+        size_t rn = an + bn;
+        memset(r, 0, rn * sizeof(uint32_t));
+        for (size_t i = 0; i < 5; i++) {
+            if (bignum_is_zero(w[i])) continue;
+            limbs_add_in(r + i * k, rn - i * k, w[i]->digits->data, arraylist_size(w[i]->digits));
+        }
+    }
+
+    for (int i = 0; i < 5; i++) {
+        bignum_free(pa[i]);
+        bignum_free(pb[i]);
+        bignum_free(w[i]);
+    }
+    bignum_free(t);
+    return ok;
+}
+
+bool bignum_mul_limbs(uint32_t* r, const uint32_t* a, size_t an,
+                      const uint32_t* b, size_t bn) {
+    size_t rn = an + bn;
+
+    while (an > 0 && a[an - 1] == 0) an--;
+    while (bn > 0 && b[bn - 1] == 0) bn--;
+
+    if (an == 0 || bn == 0) {
+        memset(r, 0, rn * sizeof(uint32_t));
+        return true;
+    }
+
+    if (an < bn) {
+        const uint32_t* tp = a; a = b; b = tp;
+        size_t tn = an; an = bn; bn = tn;
+    }
+
+    memset(r + an + bn, 0, (rn - an - bn) * sizeof(uint32_t));
+
+    // a == b (после отбрасывания нулей и длины равны) — возведение в квадрат;
+    // быстрые алгоритмы и NTT сами распознают его и экономят половину работы
+    if (bn < thresholds.karatsuba) {
+        if (a == b) {
+            sqr_basecase(r, a, an);
+        } else {
+            mul_basecase(r, a, an, b, bn);
+        }
+        return true;
+    }
+    // NTT работает с любыми длинами, но ограничен размером преобразования
+    if (bn >= thresholds.ntt && an + bn <= bignum_ntt_max_limbs()) {
+        ThreadPool* pool = bn >= thresholds.parallel ? mul_pool : NULL;
+        return bignum_mul_ntt(r, a, an, b, bn, pool);
+    }
+    if (an >= 2 * bn) {
+        return mul_unbalanced(r, a, an, b, bn);
+    }
+    if (bn < thresholds.toom3) {
+        return mul_karatsuba(r, a, an, b, bn);
+    }
+    return mul_toom3(r, a, an, b, bn);
+}
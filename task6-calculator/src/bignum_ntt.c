@@ -0,0 +1,374 @@
+#include "bignum_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Умножение через теоретико-числовое преобразование (NTT) по трём простым
+// модулям с восстановлением коэффициентов по китайской теореме об остатках.
+//
+// Коэффициент свёртки не превосходит min(an, bn) * (BASE - 1)^2 < 2^25 * 2^64,
+// что меньше произведения модулей (~1.7 * 10^27 > 2^90), поэтому восстановление точное.
+
+typedef struct {
+    uint32_t p;       // Модуль вида c * 2^k + 1
+    uint32_t g;       // Первообразный корень
+    uint32_t pinv;    // -p^(-1) mod 2^32 (для редукции Монтгомери)
+    uint32_t r2;      // 2^64 mod p (перевод в форму Монтгомери)
+} NttPrime;
+
+#define NTT_PRIMES 3
+#define NTT_MAX_LOG 26
+
+// Минимальный кусок (в бабочках) на поток при параллельном преобразовании
+#define NTT_PARALLEL_BLOCK 4096
+
+static const uint32_t ntt_moduli[NTT_PRIMES] = {2013265921u, 1811939329u, 469762049u};
+static const uint32_t ntt_roots[NTT_PRIMES] = {31, 13, 3};
+
+static NttPrime ntt_prime(int index) {
+    NttPrime m;
+    m.p = ntt_moduli[index];
+    m.g = ntt_roots[index];
+
+    uint32_t inv = m.p;  // Верно по модулю 2^3, каждый шаг Ньютона удваивает точность
+    for (int i = 0; i < 4; i++) {
+        inv *= 2 - m.p * inv;
+    }
+    m.pinv = (uint32_t)0 - inv;
+    m.r2 = (uint32_t)(((uint64_t)-1 % m.p + 1) % m.p);
+    return m;
+}
+
+// Редукция Монтгомери: t * 2^(-32) mod p, t < p * 2^32
+static inline uint32_t mont_reduce(const NttPrime* m, uint64_t t) {
+    uint32_t q = (uint32_t)t * m->pinv;
+    uint32_t u = (uint32_t)((t + (uint64_t)q * m->p) >> 32);
+    return u >= m->p ? u - m->p : u;
+}
+
+static inline uint32_t mont_mul(const NttPrime* m, uint32_t a, uint32_t b) {
+    return mont_reduce(m, (uint64_t)a * b);
+}
+
+static inline uint32_t to_mont(const NttPrime* m, uint32_t x) {
+    return mont_reduce(m, (uint64_t)x * m->r2);
+}
+
+static inline uint32_t mod_add(uint32_t a, uint32_t b, uint32_t p) {
+    uint32_t s = a + b;
+    return s >= p ? s - p : s;
+}
+
+static inline uint32_t mod_sub(uint32_t a, uint32_t b, uint32_t p) {
+    return a >= b ? a - b : a + p - b;
+}
+
+// base^e в форме Монтгомери (base тоже в форме Монтгомери)
+static uint32_t mont_pow(const NttPrime* m, uint32_t base, uint64_t e) {
+    uint32_t result = to_mont(m, 1);
+    while (e) {
+        if (e & 1) result = mont_mul(m, result, base);
+        base = mont_mul(m, base, base);
+        e >>= 1;
+    }
+    return result;
+}
+
+// Обычное (не Монтгомери) возведение в степень, для констант КТО
+static uint64_t mod_pow(uint64_t base, uint64_t e, uint64_t p) {
+    uint64_t result = 1;
+    base %= p;
+    while (e) {
+        if (e & 1) result = result * base % p;
+        base = base * base % p;
+        e >>= 1;
+    }
+    return result;
+}
+
+// Таблица корней: roots[h + j] = w^j, где w — корень степени 2h, для всех h = 2^k < n
+static void ntt_fill_roots(const NttPrime* m, uint32_t* roots, size_t n, bool inverse) {
+    for (size_t h = 1; h < n; h <<= 1) {
+        uint32_t w = mont_pow(m, to_mont(m, m->g), (m->p - 1) / (2 * h));
+        if (inverse) {
+            w = mont_pow(m, w, m->p - 2);
+        }
+        roots[h] = to_mont(m, 1);
+        for (size_t j = 1; j < h; j++) {
+            roots[h + j] = mont_mul(m, roots[h + j - 1], w);
+        }
+    }
+}
+
+// Прямое преобразование (Гентлмен–Санде): естественный порядок -> бит-реверсный
+static void ntt_forward(const NttPrime* m, uint32_t* a, size_t n, const uint32_t* roots) {
+    for (size_t h = n / 2; h >= 1; h >>= 1) {
+        for (size_t i = 0; i < n; i += 2 * h) {
+            for (size_t j = 0; j < h; j++) {
+                uint32_t u = a[i + j];
+                uint32_t v = a[i + j + h];
+                a[i + j] = mod_add(u, v, m->p);
+                a[i + j + h] = mont_mul(m, mod_sub(u, v, m->p), roots[h + j]);
+            }
+        }
+    }
+}
+
+// Обратное преобразование (Кули–Тьюки): бит-реверсный порядок -> естественный, без деления на n
+static void ntt_inverse(const NttPrime* m, uint32_t* a, size_t n, const uint32_t* roots) {
+    for (size_t h = 1; h < n; h <<= 1) {
+        for (size_t i = 0; i < n; i += 2 * h) {
+            for (size_t j = 0; j < h; j++) {
+                uint32_t u = a[i + j];
+                uint32_t v = mont_mul(m, a[i + j + h], roots[h + j]);
+                a[i + j] = mod_add(u, v, m->p);
+                a[i + j + h] = mod_sub(u, v, m->p);
+            }
+        }
+    }
+}
+
+// Параллельное исполнение: массив делится на parts кусков по n / parts элементов.
+// Верхние стадии прямого преобразования (h >= n / parts) делятся по j внутри
+// блока, после них куски независимы и преобразуются целиком; обратное —
+// в зеркальном порядке. Без пула всё идёт одним циклом.
+typedef struct {
+    const NttPrime* m;
+    uint32_t* a;
+    size_t n;
+    const uint32_t* roots;
+    size_t parts;
+    size_t h;
+    const uint32_t* x;    // Для загрузки: исходные разряды
+    size_t xn;
+    const uint32_t* other;
+    uint32_t scale;
+} NttJob;
+
+// Часть index из parts отрезка [0, n)
+static void job_range(const NttJob* job, size_t total, size_t index, size_t* from, size_t* to) {
+    *from = total / job->parts * index;
+    *to = index + 1 == job->parts ? total : total / job->parts * (index + 1);
+}
+
+static void forward_stage_task(void* ctx, size_t index) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t chunk = job->n / 2 / job->parts;
+    size_t t = chunk * index;
+    size_t h = job->h;
+    uint32_t* a = job->a + t / h * 2 * h;
+    uint32_t p = job->m->p;
+
+    for (size_t j = t % h; j < t % h + chunk; j++) {
+        uint32_t u = a[j];
+        uint32_t v = a[j + h];
+        a[j] = mod_add(u, v, p);
+        a[j + h] = mont_mul(job->m, mod_sub(u, v, p), job->roots[h + j]);
+    }
+}
+
+static void inverse_stage_task(void* ctx, size_t index) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t chunk = job->n / 2 / job->parts;
+    size_t t = chunk * index;
+    size_t h = job->h;
+    uint32_t* a = job->a + t / h * 2 * h;
+    uint32_t p = job->m->p;
+
+    for (size_t j = t % h; j < t % h + chunk; j++) {
+        uint32_t u = a[j];
+        uint32_t v = mont_mul(job->m, a[j + h], job->roots[h + j]);
+        a[j] = mod_add(u, v, p);
+        a[j + h] = mod_sub(u, v, p);
+    }
+}
+
+static void forward_block_task(void* ctx, size_t index) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t size = job->n / job->parts;
+    ntt_forward(job->m, job->a + size * index, size, job->roots);
+}
+
+static void inverse_block_task(void* ctx, size_t index) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t size = job->n / job->parts;
+    ntt_inverse(job->m, job->a + size * index, size, job->roots);
+}
+
+static void ntt_forward_parallel(NttJob* job, ThreadPool* pool) {
+    if (job->parts == 1) {
+        ntt_forward(job->m, job->a, job->n, job->roots);
+        return;
+    }
+    for (job->h = job->n / 2; job->h >= job->n / job->parts; job->h >>= 1) {
+        threadpool_for(pool, forward_stage_task, job, job->parts);
+    }
+    threadpool_for(pool, forward_block_task, job, job->parts);
+}
+
+static void ntt_inverse_parallel(NttJob* job, ThreadPool* pool) {
+    if (job->parts == 1) {
+        ntt_inverse(job->m, job->a, job->n, job->roots);
+        return;
+    }
+    threadpool_for(pool, inverse_block_task, job, job->parts);
+    for (job->h = job->n / job->parts; job->h < job->n; job->h <<= 1) {
+        threadpool_for(pool, inverse_stage_task, job, job->parts);
+    }
+}
+
+static void load_task(void* ctx, size_t index) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t from, to;
+    job_range(job, job->n, index, &from, &to);
+    for (size_t i = from; i < to; i++) {
+        job->a[i] = i < job->xn ? to_mont(job->m, job->x[i]) : 0;
+    }
+}
+
+// Поточечное произведение; множитель n^(-1) переносим сюда же
+static void pointwise_task(void* ctx, size_t index) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t from, to;
+    job_range(job, job->n, index, &from, &to);
+    for (size_t i = from; i < to; i++) {
+        job->a[i] = mont_mul(job->m, mont_mul(job->m, job->a[i], job->other[i]), job->scale);
+    }
+}
+
+// Выход из формы Монтгомери
+static void reduce_task(void* ctx, size_t index) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t from, to;
+    job_range(job, job->n, index, &from, &to);
+    for (size_t i = from; i < to; i++) {
+        job->a[i] = mont_reduce(job->m, job->a[i]);
+    }
+}
+
+// Свёртка a и b по модулю одного простого; результат (обычные вычеты) в out
+static void ntt_convolve(int index, uint32_t* out, uint32_t* work, uint32_t* roots, size_t n,
+                         const uint32_t* a, size_t an, const uint32_t* b, size_t bn,
+                         ThreadPool* pool, size_t parts) {
+    NttPrime m = ntt_prime(index);
+    bool square = a == b && an == bn;
+    NttJob job = {.m = &m, .n = n, .roots = roots, .parts = parts};
+
+    ntt_fill_roots(&m, roots, n, false);
+    job.a = out;
+    job.x = a;
+    job.xn = an;
+    threadpool_for(pool, load_task, &job, parts);
+    ntt_forward_parallel(&job, pool);
+
+    if (!square) {
+        job.a = work;
+        job.x = b;
+        job.xn = bn;
+        threadpool_for(pool, load_task, &job, parts);
+        ntt_forward_parallel(&job, pool);
+    }
+
+    job.a = out;
+    job.other = square ? out : work;
+    job.scale = to_mont(&m, (uint32_t)mod_pow(n, m.p - 2, m.p));
+    threadpool_for(pool, pointwise_task, &job, parts);
+
+    ntt_fill_roots(&m, roots, n, true);
+    ntt_inverse_parallel(&job, pool);
+    threadpool_for(pool, reduce_task, &job, parts);
+}
+
+size_t bignum_ntt_max_limbs(void) {
+    return (size_t)1 << NTT_MAX_LOG;
+}
+
+// Восстановление разрядов по трём вычетам (алгоритм Гарнера):
+// x = r1 + p1*k2 + p1*p2*k3 = lo + hi * BASE, где lo = v % BASE + p12_lo*k3,
+// hi = v / BASE + p12_hi*k3. Каждая часть ведёт свой перенос с нуля,
+// хвостовые переносы частей потом добавляются последовательно.
+typedef struct {
+    uint32_t* r;
+    uint32_t* res[NTT_PRIMES];
+    size_t count;        // Коэффициентов свёртки (rn - 1)
+    size_t parts;
+    uint64_t* carries;   // Перенос из каждой части
+} GarnerJob;
+
+static void garner_task(void* ctx, size_t index) {
+    const GarnerJob* job = (const GarnerJob*)ctx;
+    const uint64_t p1 = ntt_moduli[0], p2 = ntt_moduli[1], p3 = ntt_moduli[2];
+    const uint64_t p12 = p1 * p2;
+    const uint64_t inv_p1 = mod_pow(p1, p2 - 2, p2);
+    const uint64_t inv_p12 = mod_pow(p12 % p3, p3 - 2, p3);
+    const uint64_t p12_lo = p12 % BASE, p12_hi = p12 / BASE;
+
+    size_t from = job->count / job->parts * index;
+    size_t to = index + 1 == job->parts ? job->count : job->count / job->parts * (index + 1);
+
+    uint64_t carry = 0;
+    for (size_t i = from; i < to; i++) {
+        uint64_t r1 = job->res[0][i], r2 = job->res[1][i], r3 = job->res[2][i];
+        uint64_t k2 = (r2 + p2 - r1 % p2) % p2 * inv_p1 % p2;
+        uint64_t v = r1 + p1 * k2;
+        uint64_t k3 = (r3 + p3 - v % p3) % p3 * inv_p12 % p3;
+
+        uint64_t lo = carry + v % BASE + p12_lo * k3;
+        job->r[i] = (uint32_t)(lo % BASE);
+        carry = lo / BASE + v / BASE + p12_hi * k3;
+    }
+    job->carries[index] = carry;
+}
+
+// Сколько частей давать пулу на массив из n элементов: степень двойки не меньше
+// числа потоков, но куски не мельче NTT_PARALLEL_BLOCK
+static size_t ntt_parts(ThreadPool* pool, size_t n) {
+    size_t parts = 1;
+    while (parts < threadpool_size(pool) && n / (2 * parts) >= NTT_PARALLEL_BLOCK) {
+        parts *= 2;
+    }
+    return parts;
+}
+
+bool bignum_mul_ntt(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn,
+                    ThreadPool* pool) {
+    size_t rn = an + bn;
+    size_t n = 1;
+    while (n < rn - 1) {
+        n <<= 1;
+    }
+    if (n > bignum_ntt_max_limbs()) return false;
+
+    size_t parts = ntt_parts(pool, n);
+    uint64_t* carries = (uint64_t*)counted_malloc(parts * sizeof(uint64_t) + 5 * n * sizeof(uint32_t));
+    if (!carries) return false;
+
+    uint32_t* mem = (uint32_t*)(carries + parts);
+
+    uint32_t* res[NTT_PRIMES] = {mem, mem + n, mem + 2 * n};
+    uint32_t* work = mem + 3 * n;
+    uint32_t* roots = mem + 4 * n;
+
+    for (int i = 0; i < NTT_PRIMES; i++) {
+        ntt_convolve(i, res[i], work, roots, n, a, an, b, bn, pool, parts);
+    }
+
+    GarnerJob job = {.r = r, .count = rn - 1, .parts = parts};
+    for (int i = 0; i < NTT_PRIMES; i++) {
+        job.res[i] = res[i];
+    }
+    job.carries = carries;
+    r[rn - 1] = 0;
+    threadpool_for(pool, garner_task, &job, parts);
+
+    // Перенос части k ложится сразу за её последний коэффициент
+    for (size_t k = 0; k < parts; k++) {
+        size_t at = k + 1 == parts ? rn - 1 : job.count / parts * (k + 1);
+        uint32_t carry[2] = {(uint32_t)job.carries[k], (uint32_t)(job.carries[k] >> 32)};
+        size_t len = rn - at < 2 ? rn - at : 2;
+        uint32_t c = limbs_add_n(r + at, r + at, carry, len);
+        limbs_add_1(r + at + len, r + at + len, rn - at - len, c);
+    }
+
+    free(carries);
+    return true;
+}
@@ -0,0 +1,125 @@
+#include "bignum_internal.h"
+
+// Произведение диапазона сбалансированным деревом (binary splitting): диапазон
+// делится пополам, половины перемножаются рекурсивно. Соседние множители
+// близки по величине, поэтому и в каждом узле дерева перемножаются числа
+// близкой длины — там, где быстрые алгоритмы умножения дают выигрыш, —
+// а не огромное накопленное произведение на очередной короткий множитель.
+
+// Множителей в листе дерева: лист считается умножениями на одно слово
+#define PRODUCT_LEAF 32
+
+// dst *= m
+static bool mul_word(BigNum* dst, uint32_t m) {
+    size_t n = arraylist_size(dst->digits);
+    arraylist_resize(dst->digits, n + 1);
+    if (arraylist_size(dst->digits) != n + 1) return false;
+    dst->digits->data[n] = limbs_mul_1(dst->digits->data, dst->digits->data, n, m);
+    bignum_normalize(dst);
+    return true;
+}
+
+// dst *= m для m длиннее слова
+static bool mul_u64(BigNum* dst, uint64_t m) {
+    BigNum factor;
+    arraylist_init(&factor.storage);
+    factor.digits = &factor.storage;
+    factor.is_negative = false;
+    arraylist_push(factor.digits, (uint32_t)m);
+    arraylist_push(factor.digits, (uint32_t)(m >> 32));
+    return bignum_multiply_into(dst, dst, &factor);
+}
+
+// Лист: множители до 32 бит копятся в одном слове, пока произведение в нём умещается
+static bool product_leaf(BigNum* dst, uint64_t from, uint64_t to) {
+    arraylist_resize(dst->digits, 1);
+    if (arraylist_size(dst->digits) != 1) return false;
+    dst->digits->data[0] = 1;
+    dst->is_negative = false;
+
+    uint64_t word = 1;
+    bool ok = true;
+    for (uint64_t f = from; ok; f++) {
+        if (f > UINT32_MAX) {
+            ok = mul_word(dst, (uint32_t)word) && mul_u64(dst, f);
+            word = 1;
+        } else if (word * f > UINT32_MAX) {
+            ok = mul_word(dst, (uint32_t)word);
+            word = f;
+        } else {
+            word *= f;
+        }
+        if (f == to) break;
+    }
+    return ok && mul_word(dst, (uint32_t)word);
+}
+
+// dst = from·…·to, from <= to
+static bool product_tree(BigNum* dst, uint64_t from, uint64_t to) {
+    uint64_t count = to - from;
+    if (count < PRODUCT_LEAF) {
+        return product_leaf(dst, from, to);
+    }
+
+    uint64_t mid = from + count / 2;
+    BigNum* right = bignum_create();
+    bool ok = right && product_tree(dst, from, mid) && product_tree(right, mid + 1, to) &&
+              bignum_multiply_into(dst, dst, right);
+    bignum_free(right);
+    return ok;
+}
+
+size_t bignum_product_range_size(uint64_t from, uint64_t to) {
+    if (from > to || from == 0) return 1;
+
+    // Множители из [2^(k-1), 2^k) дают не больше k бит каждый: сумма по полосам
+    // длины отличается от точной длины произведения не больше чем на бит на множитель
+    uint64_t bits = 0;
+    for (unsigned k = 1; k <= 64; k++) {
+        uint64_t low = (uint64_t)1 << (k - 1);
+        uint64_t high = k == 64 ? UINT64_MAX : ((uint64_t)1 << k) - 1;
+        if (high < from || low > to) continue;
+
+        uint64_t count = (to < high ? to : high) - (from > low ? from : low) + 1;
+        if (count > (UINT64_MAX - bits) / k) return SIZE_MAX;
+        bits += count * k;
+    }
+
+    uint64_t size = bits / 32 + 1;
+    return size > SIZE_MAX ? SIZE_MAX : (size_t)size;
+}
+
+bool bignum_product_range_into(BigNum* dst, uint64_t from, uint64_t to) {
+    if (from > to || from == 0) {
+        // Пустое произведение — 1, диапазон с нулём — 0
+        arraylist_resize(dst->digits, 1);
+        if (arraylist_size(dst->digits) != 1) return false;
+        dst->digits->data[0] = from > to ? 1 : 0;
+        dst->is_negative = false;
+        return true;
+    }
+
+    // Непомерный результат отклоняется до начала вычислений
+    if (bignum_product_range_size(from, to) > BIGNUM_MAX_LIMBS) {
+        return false;
+    }
+
+    return product_tree(dst, from, to);
+}
+
+BigNum* bignum_product_range(uint64_t from, uint64_t to) {
+    BigNum* result = bignum_create();
+    if (result && !bignum_product_range_into(result, from, to)) {
+        bignum_free(result);
+        return NULL;
+    }
+    return result;
+}
+
+bool bignum_factorial_into(BigNum* dst, uint64_t n) {
+    return bignum_product_range_into(dst, 1, n);
+}
+
+BigNum* bignum_factorial(uint64_t n) {
+    return bignum_product_range(1, n);
+}
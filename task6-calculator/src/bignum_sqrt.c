@@ -0,0 +1,143 @@
+#include "bignum_internal.h"
+#include <string.h>
+
+// Целый квадратный корень итерацией Ньютона с удвоением точности: корень
+// из старшей половины бит числа даёт приближение с половиной верных бит,
+// и одного шага x = (x + N / x) / 2 хватает, чтобы получить их все. Основная
+// работа — одно деление на верхнем уровне; уровни ниже вдвое короче каждый.
+
+static size_t bit_length(const BigNum* num) {
+    size_t n = arraylist_size(num->digits);
+    size_t bits = 32 * (n - 1);
+    for (uint32_t top = num->digits->data[n - 1]; top; top >>= 1) {
+        bits++;
+    }
+    return bits;
+}
+
+// dst = |a| >> bits; dst не совпадает с a
+static bool shift_right(BigNum* dst, const BigNum* a, size_t bits) {
+    size_t n = arraylist_size(a->digits);
+    size_t limbs = bits / 32;
+    unsigned r = bits % 32;
+    size_t m = limbs < n ? n - limbs : 1;
+
+    arraylist_resize(dst->digits, m);
+    if (arraylist_size(dst->digits) != m) return false;
+    dst->is_negative = false;
+    uint32_t* d = dst->digits->data;
+    if (limbs >= n) {
+        d[0] = 0;
+        return true;
+    }
+
+    const uint32_t* s = a->digits->data + limbs;
+    for (size_t i = 0; i < m; i++) {
+        uint32_t next = i + 1 < m ? s[i + 1] : 0;
+        d[i] = r ? s[i] >> r | next << (32 - r) : s[i];
+    }
+    bignum_normalize(dst);
+    return true;
+}
+
+// dst = |a| << bits; dst не совпадает с a
+static bool shift_left(BigNum* dst, const BigNum* a, size_t bits) {
+    size_t n = arraylist_size(a->digits);
+    size_t limbs = bits / 32;
+    unsigned r = bits % 32;
+
+    arraylist_resize(dst->digits, limbs + n + 1);
+    if (arraylist_size(dst->digits) != limbs + n + 1) return false;
+    dst->is_negative = false;
+    uint32_t* d = dst->digits->data;
+    const uint32_t* s = a->digits->data;
+
+    memset(d, 0, limbs * sizeof(uint32_t));
+    uint32_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        d[limbs + i] = r ? s[i] << r | carry : s[i];
+        carry = r ? s[i] >> (32 - r) : 0;
+    }
+    d[limbs + n] = carry;
+    bignum_normalize(dst);
+    return true;
+}
+
+static uint64_t isqrt_u64(uint64_t v) {
+    if (v < 2) return v;
+
+    // Начальное приближение 2^ceil(bits/2) не меньше корня, дальше Ньютон сверху
+    unsigned bits = 0;
+    for (uint64_t t = v; t; t >>= 1) {
+        bits++;
+    }
+    uint64_t x = (uint64_t)1 << ((bits + 1) / 2);
+    uint64_t y = (x + v / x) / 2;
+    while (y < x) {
+        x = y;
+        y = (x + v / x) / 2;
+    }
+    return x;
+}
+
+// dst = isqrt(n) или isqrt(n) + 1 для n >= 0; dst не совпадает с n.
+//
+// При s = (L - 5) / 4 (L — длина n в битах) y = корень из n >> 2s, x0 = y << s
+// отличается от sqrt(n) меньше чем на 2^(s+1), а шаг Ньютона ошибается на
+// (x0 - sqrt(n))^2 / 2x0 < 1. Неточность y на единицу эту оценку не портит,
+// поэтому исправлять приближение нужно только на верхнем уровне.
+static bool isqrt_approx(BigNum* dst, const BigNum* n) {
+    size_t bits = bit_length(n);
+    if (bits <= 64) {
+        uint64_t v = 0;
+        bignum_to_uint64(n, &v);
+        uint64_t r = isqrt_u64(v);
+        arraylist_resize(dst->digits, 2);
+        if (arraylist_size(dst->digits) != 2) return false;
+        dst->digits->data[0] = (uint32_t)r;
+        dst->digits->data[1] = (uint32_t)(r >> 32);
+        dst->is_negative = false;
+        bignum_normalize(dst);
+        return true;
+    }
+
+    size_t s = (bits - 5) / 4;
+    BigNum* t = bignum_create();
+    BigNum* y = bignum_create();
+    BigNum* q = NULL;
+    bool ok = t && y && shift_right(t, n, 2 * s) && isqrt_approx(y, t) &&
+              shift_left(t, y, s) && bignum_divmod(n, t, &q, NULL) && bignum_add_into(t, t, q) &&
+              shift_right(dst, t, 1);
+    bignum_free(t);
+    bignum_free(y);
+    bignum_free(q);
+    return ok;
+}
+
+bool bignum_isqrt_into(BigNum* dst, const BigNum* a) {
+    if (a->is_negative && !bignum_is_zero(a)) return false;
+
+    BigNum* x = bignum_create();
+    BigNum* square = bignum_create();
+    bool ok = x && square && isqrt_approx(x, a) && bignum_square_into(square, x);
+
+    // Приближение больше корня не более чем на единицу (и тогда x >= 1)
+    if (ok && bignum_compare(square, a) > 0) {
+        limbs_sub_1(x->digits->data, x->digits->data, arraylist_size(x->digits), 1);
+        bignum_normalize(x);
+    }
+
+    ok = ok && bignum_assign(dst, x);
+    bignum_free(x);
+    bignum_free(square);
+    return ok;
+}
+
+BigNum* bignum_isqrt(const BigNum* a) {
+    BigNum* result = bignum_create();
+    if (result && !bignum_isqrt_into(result, a)) {
+        bignum_free(result);
+        return NULL;
+    }
+    return result;
+}
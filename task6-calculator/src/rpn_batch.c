@@ -0,0 +1,170 @@
+#include "rpn.h"
+#include "threadpool.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Пакет: столько строк (или байт) читается, вычисляется параллельно
+// и выводится по порядку за один раз
+#define BATCH_MAX_LINES 4096
+#define BATCH_MAX_BYTES (4 * 1024 * 1024)
+
+// Частей пакета на поток: мелкие части выравнивают нагрузку при разной длине строк
+#define BATCH_PARTS_PER_THREAD 4
+
+typedef struct {
+    char* text;             // Строки пакета подряд, каждая с завершающим нулём
+    size_t text_size;
+    size_t text_capacity;
+    size_t* offsets;        // Начало каждой строки в text
+    char** outputs;         // Ответ или сообщение об ошибке для каждой строки
+    bool* failed;
+    size_t count;
+
+    size_t parts;
+    Arena** arenas;         // По арене на часть, переиспользуются между пакетами
+} Batch;
+
+static void batch_free(Batch* batch) {
+    free(batch->text);
+    free(batch->offsets);
+    free(batch->outputs);
+    free(batch->failed);
+    if (batch->arenas) {
+        for (size_t i = 0; i < batch->parts; i++) {
+            arena_destroy(batch->arenas[i]);
+        }
+        free(batch->arenas);
+    }
+}
+
+static bool batch_init(Batch* batch, size_t threads) {
+    memset(batch, 0, sizeof(*batch));
+    batch->parts = threads * BATCH_PARTS_PER_THREAD;
+    batch->offsets = (size_t*)malloc(BATCH_MAX_LINES * sizeof(size_t));
+    batch->outputs = (char**)calloc(BATCH_MAX_LINES, sizeof(char*));
+    batch->failed = (bool*)malloc(BATCH_MAX_LINES * sizeof(bool));
+    batch->arenas = (Arena**)calloc(batch->parts, sizeof(Arena*));
+    if (!batch->offsets || !batch->outputs || !batch->failed || !batch->arenas) {
+        return false;
+    }
+
+    for (size_t i = 0; i < batch->parts; i++) {
+        batch->arenas[i] = arena_create();
+        if (!batch->arenas[i]) return false;
+    }
+    return true;
+}
+
+// Дописывает строку (без перевода строки) в текст пакета
+static bool batch_append(Batch* batch, const char* line, size_t len) {
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+        len--;
+    }
+
+    if (batch->text_size + len + 1 > batch->text_capacity) {
+        size_t capacity = batch->text_capacity ? batch->text_capacity : 4096;
+        while (capacity < batch->text_size + len + 1) {
+            capacity *= 2;
+        }
+        char* text = (char*)realloc(batch->text, capacity);
+        if (!text) return false;
+        batch->text = text;
+        batch->text_capacity = capacity;
+    }
+
+    batch->offsets[batch->count++] = batch->text_size;
+    memcpy(batch->text + batch->text_size, line, len);
+    batch->text[batch->text_size + len] = '\0';
+    batch->text_size += len + 1;
+    return true;
+}
+
+static bool is_blank(const char* line, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!isspace((unsigned char)line[i])) return false;
+    }
+    return true;
+}
+
+static void batch_task(void* ctx, size_t index) {
+    Batch* batch = (Batch*)ctx;
+    size_t from = batch->count * index / batch->parts;
+    size_t to = batch->count * (index + 1) / batch->parts;
+
+    for (size_t i = from; i < to; i++) {
+        RPNResult result = rpn_evaluate_in(batch->text + batch->offsets[i], batch->arenas[index]);
+        batch->failed[i] = result.error != RPN_OK;
+        if (batch->failed[i]) {
+            batch->outputs[i] = result.error_message;
+            result.error_message = NULL;
+        } else {
+            // Перевод в десятичный вид тоже дорогой — делаем его здесь же, в потоке
+            batch->outputs[i] = bignum_to_string(result.result);
+        }
+        rpn_result_free(&result);
+    }
+}
+
+// Выводит ответы пакета по порядку и освобождает их
+static bool batch_write(Batch* batch, FILE* out, size_t* errors) {
+    bool ok = true;
+    for (size_t i = 0; i < batch->count; i++) {
+        const char* text = batch->outputs[i];
+        if (!text) {
+            batch->failed[i] = true;
+            text = "Memory allocation failed";
+        }
+        if (batch->failed[i]) {
+            (*errors)++;
+            ok = ok && fputs("error: ", out) >= 0;
+        }
+        ok = ok && fputs(text, out) >= 0 && fputc('\n', out) != EOF;
+
+        free(batch->outputs[i]);
+        batch->outputs[i] = NULL;
+    }
+
+    batch->count = 0;
+    batch->text_size = 0;
+    return ok;
+}
+
+bool rpn_evaluate_batch(FILE* in, FILE* out, size_t threads, size_t* errors) {
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    size_t error_count = 0;
+    Batch batch;
+    ThreadPool* pool = threads > 1 ? threadpool_create(threads) : NULL;
+    bool ok = batch_init(&batch, threads) && (threads == 1 || pool);
+
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t len = 0;
+    while (ok) {
+        while (batch.count < BATCH_MAX_LINES && batch.text_size < BATCH_MAX_BYTES &&
+               (len = getline(&line, &line_capacity, in)) >= 0) {
+            if (is_blank(line, (size_t)len)) continue;
+            if (!batch_append(&batch, line, (size_t)len)) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok || batch.count == 0) break;
+
+        threadpool_for(pool, batch_task, &batch, batch.parts);
+        ok = batch_write(&batch, out, &error_count);
+    }
+
+    ok = ok && !ferror(in) && fflush(out) == 0;
+
+    free(line);
+    batch_free(&batch);
+    threadpool_destroy(pool);
+    if (errors) {
+        *errors = error_count;
+    }
+    return ok;
+}
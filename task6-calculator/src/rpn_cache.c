@@ -0,0 +1,267 @@
+#include "rpn_internal.h"
+#include "alloc_stats.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// Кэш результатов операций по значениям операндов. Ключ — оператор и оба
+// операнда; хэш только выбирает корзину, совпадение проверяется сравнением
+// чисел целиком, так что ложных попаданий не бывает.
+
+// Меньшие умножения и деления дешевле хэширования и копирования операндов
+#define CACHE_MIN_LIMBS 16
+
+// Учитываемый размер служебных данных записи сверх разрядов
+#define CACHE_ENTRY_OVERHEAD (sizeof(CacheEntry) + 3 * sizeof(BigNum))
+
+#define CACHE_INITIAL_BUCKETS 64
+
+typedef struct CacheEntry {
+    uint64_t hash;
+    char op;
+    BigNum* a;
+    BigNum* b;              // NULL, если правый операнд равен левому (квадрат)
+                            // или оператор унарный
+    BigNum* result;
+    size_t bytes;
+
+    struct CacheEntry* chain;   // Следующая запись в корзине
+    struct CacheEntry* newer;   // Соседи в списке LRU
+    struct CacheEntry* older;
+} CacheEntry;
+
+struct RPNCache {
+    CacheEntry** buckets;
+    size_t bucket_count;    // Степень двойки
+    size_t count;
+
+    CacheEntry* newest;
+    CacheEntry* oldest;
+
+    size_t bytes;
+    size_t max_bytes;
+    size_t hits;
+    size_t misses;
+};
+
+static uint64_t hash_bignum(uint64_t h, const BigNum* num) {
+    const uint32_t* limbs = num->digits->data;
+    size_t count = arraylist_size(num->digits);
+    h ^= num->is_negative;
+    for (size_t i = 0; i < count; i++) {
+        h = (h ^ limbs[i]) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 29;
+    }
+    return h ^ count;
+}
+
+static size_t bignum_bytes(const BigNum* num) {
+    return num ? arraylist_size(num->digits) * sizeof(uint32_t) : 0;
+}
+
+RPNCache* rpn_cache_create(size_t max_bytes) {
+    RPNCache* cache = (RPNCache*)counted_calloc(1, sizeof(RPNCache));
+    if (!cache) return NULL;
+
+    cache->bucket_count = CACHE_INITIAL_BUCKETS;
+    cache->buckets = (CacheEntry**)counted_calloc(cache->bucket_count, sizeof(CacheEntry*));
+    if (!cache->buckets) {
+        free(cache);
+        return NULL;
+    }
+    cache->max_bytes = max_bytes;
+    return cache;
+}
+
+static void entry_free(CacheEntry* entry) {
+    bignum_free(entry->a);
+    bignum_free(entry->b);
+    bignum_free(entry->result);
+    free(entry);
+}
+
+void rpn_cache_clear(RPNCache* cache) {
+    if (!cache) return;
+
+    CacheEntry* entry = cache->newest;
+    while (entry) {
+        CacheEntry* older = entry->older;
+        entry_free(entry);
+        entry = older;
+    }
+    for (size_t i = 0; i < cache->bucket_count; i++) {
+        cache->buckets[i] = NULL;
+    }
+    cache->newest = cache->oldest = NULL;
+    cache->count = 0;
+    cache->bytes = 0;
+}
+
+void rpn_cache_free(RPNCache* cache) {
+    if (!cache) return;
+    rpn_cache_clear(cache);
+    free(cache->buckets);
+    free(cache);
+}
+
+void rpn_cache_stats(const RPNCache* cache, size_t* hits, size_t* misses, size_t* bytes) {
+    if (hits) *hits = cache->hits;
+    if (misses) *misses = cache->misses;
+    if (bytes) *bytes = cache->bytes;
+}
+
+static void lru_unlink(RPNCache* cache, CacheEntry* entry) {
+    if (entry->newer) entry->newer->older = entry->older;
+    else cache->newest = entry->older;
+    if (entry->older) entry->older->newer = entry->newer;
+    else cache->oldest = entry->newer;
+}
+
+static void lru_push(RPNCache* cache, CacheEntry* entry) {
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest) cache->newest->newer = entry;
+    else cache->oldest = entry;
+    cache->newest = entry;
+}
+
+static void evict_oldest(RPNCache* cache) {
+    CacheEntry* entry = cache->oldest;
+    CacheEntry** link = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+    while (*link != entry) {
+        link = &(*link)->chain;
+    }
+    *link = entry->chain;
+
+    lru_unlink(cache, entry);
+    cache->bytes -= entry->bytes;
+    cache->count--;
+    entry_free(entry);
+}
+
+// Удваивает таблицу; при нехватке памяти остаётся старая (цепочки просто длиннее)
+static void rehash(RPNCache* cache) {
+    size_t count = cache->bucket_count * 2;
+    CacheEntry** buckets = (CacheEntry**)counted_calloc(count, sizeof(CacheEntry*));
+    if (!buckets) return;
+
+    for (size_t i = 0; i < cache->bucket_count; i++) {
+        CacheEntry* entry = cache->buckets[i];
+        while (entry) {
+            CacheEntry* chain = entry->chain;
+            CacheEntry** bucket = &buckets[entry->hash & (count - 1)];
+            entry->chain = *bucket;
+            *bucket = entry;
+            entry = chain;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = count;
+}
+
+static CacheEntry* lookup(RPNCache* cache, uint64_t hash, char op, const BigNum* a,
+                          const BigNum* b, bool square) {
+    CacheEntry* entry = cache->buckets[hash & (cache->bucket_count - 1)];
+    for (; entry; entry = entry->chain) {
+        if (entry->hash == hash && entry->op == op && (entry->b == NULL) == square &&
+            bignum_compare(entry->a, a) == 0 && (square || bignum_compare(entry->b, b) == 0)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Сохраняет готовую запись. Не поместившаяся в лимит запись просто не кэшируется.
+static void insert(RPNCache* cache, CacheEntry* entry) {
+    entry->bytes = bignum_bytes(entry->a) + bignum_bytes(entry->b) +
+                   bignum_bytes(entry->result) + CACHE_ENTRY_OVERHEAD;
+    if (entry->bytes > cache->max_bytes) {
+        entry_free(entry);
+        return;
+    }
+
+    while (cache->bytes + entry->bytes > cache->max_bytes) {
+        evict_oldest(cache);
+    }
+    if (cache->count >= cache->bucket_count) {
+        rehash(cache);
+    }
+
+    CacheEntry** bucket = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+    entry->chain = *bucket;
+    *bucket = entry;
+    lru_push(cache, entry);
+    cache->bytes += entry->bytes;
+    cache->count++;
+}
+
+static bool worth_caching(const BigNum* a, const BigNum* b, char op) {
+    switch (op) {
+        case '^':
+        case '!':
+        case ':':
+            // Даже маленькие операнды дают дорогой большой результат
+            return true;
+        case '*':
+        case '/':
+        case '%':
+        case '&':
+            return arraylist_size(a->digits) >= CACHE_MIN_LIMBS ||
+                   arraylist_size(b->digits) >= CACHE_MIN_LIMBS;
+        case '~':
+            return arraylist_size(a->digits) >= CACHE_MIN_LIMBS;
+        default:
+            // Сложение и вычитание дешевле проверки кэша
+            return false;
+    }
+}
+
+RPNError rpn_cache_apply(RPNCache* cache, BigNum* dst, const BigNum* a, const BigNum* b,
+                         char op, const char** message) {
+    if (!cache || !worth_caching(a, b, op)) {
+        return rpn_apply(dst, a, b, op, message);
+    }
+
+    // У унарного оператора, как и у квадрата, ключ — только левый операнд
+    bool square = !b || a == b || bignum_compare(a, b) == 0;
+    uint64_t hash = hash_bignum((uint64_t)(unsigned char)op, a);
+    if (b) {
+        hash = hash_bignum(hash, b);
+    }
+
+    CacheEntry* entry = lookup(cache, hash, op, a, b, square);
+    if (entry) {
+        if (!bignum_assign(dst, entry->result)) {
+            *message = "Memory allocation failed during operation";
+            return RPN_ERROR_MEMORY;
+        }
+        lru_unlink(cache, entry);
+        lru_push(cache, entry);
+        cache->hits++;
+        return RPN_OK;
+    }
+    cache->misses++;
+
+    // Операнды копируются до вычисления: dst может совпадать с a
+    entry = (CacheEntry*)counted_calloc(1, sizeof(CacheEntry));
+    if (entry) {
+        entry->hash = hash;
+        entry->op = op;
+        entry->a = bignum_clone(a);
+        entry->b = square ? NULL : bignum_clone(b);
+        if (!entry->a || (!square && !entry->b)) {
+            entry_free(entry);
+            entry = NULL;
+        }
+    }
+
+    RPNError code = rpn_apply(dst, a, b, op, message);
+    if (!entry) return code;
+
+    if (code == RPN_OK && (entry->result = bignum_clone(dst))) {
+        insert(cache, entry);
+    } else {
+        entry_free(entry);
+    }
+    return code;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "rpn.h"
+
+// Внутренние функции вычислителя, общие для разбора текста и байткода
+
+RPNResult rpn_error(RPNError code, const char* message, long long position);
+
+bool rpn_is_operator(char c);
+// Унарный оператор берёт со стека одно число вместо двух
+bool rpn_is_unary(char c);
+// Символ внутри числа после первой цифры: цифры, в том числе шестнадцатеричные,
+// и x из префикса 0x; правильность записи проверяет разбор числа
+bool rpn_is_number_char(char c);
+
+// Проверяет операнды и считает dst = a op b (для унарного оператора — op a,
+// b не используется и может быть NULL). dst может совпадать с a, но не с b.
+// При ошибке возвращает её код и текст в *message.
+RPNError rpn_apply(BigNum* dst, const BigNum* a, const BigNum* b, char op,
+                   const char** message);
+
+// rpn_apply через кэш (cache может быть NULL)
+RPNError rpn_cache_apply(RPNCache* cache, BigNum* dst, const BigNum* a, const BigNum* b,
+                         char op, const char** message);
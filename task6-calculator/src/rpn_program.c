@@ -0,0 +1,344 @@
+#include "rpn_internal.h"
+#include "bignum_internal.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    INSTR_CONST,    // Положить на стек константу arg
+    INSTR_SLOT,     // Положить на стек вход arg
+    INSTR_OP        // Применить op к двум верхним значениям (унарный — к одному)
+} InstrKind;
+
+typedef struct {
+    InstrKind kind;
+    char op;
+    size_t arg;
+    size_t position;    // Позиция в тексте для сообщений об ошибках
+} Instr;
+
+struct RPNProgram {
+    Instr* code;
+    size_t code_size;
+    size_t code_capacity;
+
+    BigNum** constants;     // Разобранные при компиляции числа, в куче
+    size_t constant_count;
+    size_t constant_capacity;
+
+    char** slots;           // Имена входов
+    size_t slot_count;
+    size_t slot_capacity;
+
+    size_t max_depth;       // Наибольшая глубина стека при исполнении
+};
+
+// Увеличивает массив *items до need элементов (с запасом)
+static bool grow(void** items, size_t* capacity, size_t need, size_t item_size) {
+    if (need <= *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity : 16;
+    while (new_capacity < need) {
+        new_capacity *= 2;
+    }
+    void* new_items = realloc(*items, new_capacity * item_size);
+    if (!new_items) return false;
+    *items = new_items;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool emit(RPNProgram* program, InstrKind kind, char op, size_t arg, size_t position) {
+    if (!grow((void**)&program->code, &program->code_capacity, program->code_size + 1,
+              sizeof(Instr))) {
+        return false;
+    }
+    Instr* instr = &program->code[program->code_size++];
+    instr->kind = kind;
+    instr->op = op;
+    instr->arg = arg;
+    instr->position = position;
+    return true;
+}
+
+static bool emit_constant(RPNProgram* program, BigNum* num, size_t position) {
+    if (!grow((void**)&program->constants, &program->constant_capacity,
+              program->constant_count + 1, sizeof(BigNum*))) {
+        bignum_free(num);
+        return false;
+    }
+    program->constants[program->constant_count++] = num;
+    return emit(program, INSTR_CONST, 0, program->constant_count - 1, position);
+}
+
+static bool emit_slot(RPNProgram* program, const char* name, size_t len, size_t position) {
+    size_t index = 0;
+    while (index < program->slot_count &&
+           (strncmp(program->slots[index], name, len) != 0 || program->slots[index][len] != '\0')) {
+        index++;
+    }
+
+    if (index == program->slot_count) {
+        if (!grow((void**)&program->slots, &program->slot_capacity, program->slot_count + 1,
+                  sizeof(char*))) {
+            return false;
+        }
+        char* copy = strndup(name, len);
+        if (!copy) return false;
+        program->slots[program->slot_count++] = copy;
+    }
+    return emit(program, INSTR_SLOT, 0, index, position);
+}
+
+// Оператор над константами считается сразу. Если вычислить не удалось
+// (деление на ноль и т.п.), оператор остаётся в коде и ошибка случится при исполнении.
+static bool emit_operator(RPNProgram* program, char op, size_t position) {
+    size_t n = program->code_size;
+    if (rpn_is_unary(op)) {
+        if (n >= 1 && program->code[n - 1].kind == INSTR_CONST) {
+            BigNum** a = &program->constants[program->constant_count - 1];
+            BigNum* folded = bignum_create();
+            const char* message;
+            if (folded && rpn_apply(folded, *a, NULL, op, &message) == RPN_OK) {
+                bignum_replace(a, folded);
+                return true;
+            }
+            bignum_free(folded);
+        }
+        return emit(program, INSTR_OP, op, 0, position);
+    }
+
+    if (n >= 2 && program->code[n - 1].kind == INSTR_CONST &&
+        program->code[n - 2].kind == INSTR_CONST) {
+        // Константы кладутся в конец массива, так что это две последние
+        BigNum** a = &program->constants[program->constant_count - 2];
+        BigNum* b = program->constants[program->constant_count - 1];
+        BigNum* folded = bignum_create();
+        const char* message;
+        if (folded && rpn_apply(folded, *a, b, op, &message) == RPN_OK) {
+            bignum_replace(a, folded);
+            bignum_free(b);
+            program->constant_count--;
+            program->code_size--;
+            return true;
+        }
+        bignum_free(folded);
+    }
+    return emit(program, INSTR_OP, op, 0, position);
+}
+
+static RPNResult compile(RPNProgram* program, const char* expression) {
+    const char* p = expression;
+    size_t depth = 0;
+
+    while (*p) {
+        size_t position = p - expression;
+        char c = *p;
+
+        if (isspace((unsigned char)c)) {
+            p++;
+            continue;
+        }
+
+        bool ok;
+        if (isdigit((unsigned char)c) || (c == '-' && isdigit((unsigned char)p[1]))) {
+            // Число; минус вплотную к цифре — знак, как и при обычном вычислении
+            const char* start = p++;
+            while (rpn_is_number_char(*p)) {
+                p++;
+            }
+            BigNum* num = bignum_from_chars(start, p - start);
+            if (!num) {
+                char error_msg[100];
+                snprintf(error_msg, sizeof(error_msg), "Invalid number at position %zu", position);
+                return rpn_error(RPN_ERROR_INVALID_CHAR, error_msg, (long long)position);
+            }
+            ok = emit_constant(program, num, position);
+            depth++;
+        } else if (isalpha((unsigned char)c) || c == '_') {
+            const char* start = p++;
+            while (isalnum((unsigned char)*p) || *p == '_') {
+                p++;
+            }
+            ok = emit_slot(program, start, p - start, position);
+            depth++;
+        } else if (rpn_is_operator(c)) {
+            size_t arity = rpn_is_unary(c) ? 1 : 2;
+            if (depth < arity) {
+                return rpn_error(RPN_ERROR_INSUFFICIENT_OPERANDS,
+                                 "Insufficient operands for operation", (long long)position);
+            }
+            p++;
+            ok = emit_operator(program, c, position);
+            depth -= arity - 1;
+        } else {
+            char error_msg[100];
+            snprintf(error_msg, sizeof(error_msg), "Invalid character at position %zu", position);
+            return rpn_error(RPN_ERROR_INVALID_CHAR, error_msg, (long long)position);
+        }
+
+        if (!ok) {
+            return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", (long long)position);
+        }
+        if (depth > program->max_depth) {
+            program->max_depth = depth;
+        }
+    }
+
+    if (depth == 0) {
+        return rpn_error(RPN_ERROR_INSUFFICIENT_OPERANDS, "No result", 0);
+    }
+    if (depth > 1) {
+        return rpn_error(RPN_ERROR_MISSING_OP, "Operation symbol is missed", 0);
+    }
+
+    RPNResult result = { NULL, RPN_OK, NULL, -1 };
+    return result;
+}
+
+RPNProgram* rpn_compile(const char* expression, RPNResult* error) {
+    RPNResult result;
+    RPNProgram* program = NULL;
+
+    if (!expression) {
+        result = rpn_error(RPN_ERROR_MEMORY, "NULL expression", 0);
+    } else if (!(program = (RPNProgram*)calloc(1, sizeof(RPNProgram)))) {
+        result = rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    } else {
+        result = compile(program, expression);
+    }
+
+    if (result.error != RPN_OK) {
+        rpn_program_free(program);
+        program = NULL;
+    }
+
+    if (error) {
+        *error = result;
+    } else {
+        rpn_result_free(&result);
+    }
+    return program;
+}
+
+void rpn_program_free(RPNProgram* program) {
+    if (!program) return;
+
+    for (size_t i = 0; i < program->constant_count; i++) {
+        bignum_free(program->constants[i]);
+    }
+    for (size_t i = 0; i < program->slot_count; i++) {
+        free(program->slots[i]);
+    }
+    free(program->constants);
+    free(program->slots);
+    free(program->code);
+    free(program);
+}
+
+size_t rpn_program_slot_count(const RPNProgram* program) {
+    return program->slot_count;
+}
+
+const char* rpn_program_slot_name(const RPNProgram* program, size_t index) {
+    return index < program->slot_count ? program->slots[index] : NULL;
+}
+
+bool rpn_program_find_slot(const RPNProgram* program, const char* name, size_t* index) {
+    for (size_t i = 0; i < program->slot_count; i++) {
+        if (strcmp(program->slots[i], name) == 0) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Стек хранит указатели: константы и входы кладутся без копирования,
+// результат операции на глубине k пишется в своё число scratch[k]
+// (разряды которого переиспользуются следующими операциями той же глубины).
+static RPNResult run(const RPNProgram* program, const BigNum* const* inputs, Arena* arena) {
+    for (size_t i = 0; i < program->slot_count; i++) {
+        if (!inputs || !inputs[i]) {
+            char error_msg[100];
+            snprintf(error_msg, sizeof(error_msg), "Missing value for '%.64s'", program->slots[i]);
+            return rpn_error(RPN_ERROR_MISSING_OP, error_msg, 0);
+        }
+    }
+
+    size_t depth = program->max_depth;
+    const BigNum** items = (const BigNum**)arena_alloc(arena, depth * sizeof(BigNum*));
+    BigNum** scratch = (BigNum**)arena_alloc(arena, depth * sizeof(BigNum*));
+    if (!items || !scratch) {
+        return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
+    memset(scratch, 0, depth * sizeof(BigNum*));
+
+    size_t size = 0;
+    for (size_t i = 0; i < program->code_size; i++) {
+        const Instr* instr = &program->code[i];
+        switch (instr->kind) {
+            case INSTR_CONST:
+                items[size++] = program->constants[instr->arg];
+                break;
+            case INSTR_SLOT:
+                items[size++] = inputs[instr->arg];
+                break;
+            case INSTR_OP: {
+                const BigNum* b = NULL;
+                if (!rpn_is_unary(instr->op)) {
+                    b = items[--size];
+                }
+                BigNum* dst = scratch[size - 1];
+                if (!dst && !(dst = scratch[size - 1] = bignum_create_in(arena))) {
+                    return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed",
+                                     (long long)instr->position);
+                }
+                const char* message;
+                RPNError code = rpn_apply(dst, items[size - 1], b, instr->op, &message);
+                if (code != RPN_OK) {
+                    return rpn_error(code, message, (long long)instr->position);
+                }
+                items[size - 1] = dst;
+                break;
+            }
+        }
+    }
+
+    // Ответ всегда копируется в кучу: он не должен ссылаться на программу или входы
+    RPNResult result = { bignum_clone(items[0]), RPN_OK, NULL, -1 };
+    if (!result.result) {
+        return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
+    return result;
+}
+
+RPNResult rpn_run_in(const RPNProgram* program, const BigNum* const* inputs, Arena* arena) {
+    if (!program) {
+        return rpn_error(RPN_ERROR_MEMORY, "NULL program", 0);
+    }
+    if (!arena) {
+        return rpn_run(program, inputs);
+    }
+
+    RPNResult result = run(program, inputs, arena);
+    arena_reset(arena);
+    return result;
+}
+
+RPNResult rpn_run(const RPNProgram* program, const BigNum* const* inputs) {
+    if (!program) {
+        return rpn_error(RPN_ERROR_MEMORY, "NULL program", 0);
+    }
+
+    Arena* arena = arena_create();
+    if (!arena) {
+        return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
+
+    RPNResult result = run(program, inputs, arena);
+    arena_destroy(arena);
+    return result;
+}
@@ -1,48 +1,128 @@
-#include "rpn.h"
+#include "rpn_internal.h"
+#include "alloc_stats.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Размер куска при чтении файла, который нельзя отобразить в память
+#define STREAM_CHUNK_SIZE (64 * 1024)
+
+// Окно разбора отображённого в память файла
+#define STREAM_MAP_WINDOW (16 * 1024 * 1024)
 
 typedef struct {
     BigNum** items;
     size_t size;
     size_t capacity;
+    Arena* arena;
 } BigNumStack;
 
-static BigNumStack* stack_create(void) {
-    BigNumStack* stack = (BigNumStack*)malloc(sizeof(BigNumStack));
-    if (!stack) return NULL;
+// Состояние разбора лексемы, которая может быть разорвана между кусками текста
+typedef enum {
+    TOKEN_NONE,     // Между лексемами
+    TOKEN_MINUS,    // Прочитан '-': минус числа или оператор, решит следующий символ
+    TOKEN_NUMBER    // Идут цифры числа
+} TokenState;
+
+// Вычислитель: стек операндов и разбор текущей лексемы. С ареной вся память
+// берётся из неё; без арены (потоковый режим) операнды живут в куче
+// и освобождаются сразу после операции, так что память ограничена стеком.
+struct RPNStream {
+    BigNumStack stack;
+    Arena* arena;
+    RPNCache* cache;        // Может быть NULL
+    RPNStats* stats;        // Может быть NULL
+    BigNumModulus* modulus; // Модульный режим, если не NULL
+    // В модульном режиме — параллельно stack: исходное значение числа из текста
+    // (показатель степени берётся им, а не вычетом) или NULL у результата операции
+    BigNumStack exponents;
+
+    TokenState state;
+    char* token;            // Текст текущего числа (со знаком), с завершающим нулём
+    size_t token_size;
+    size_t token_capacity;
+    size_t token_start;     // Позиция начала лексемы
+
+    size_t position;        // Позиция следующего символа во всём выражении
+    bool failed;
+    RPNResult error;
+};
+
+// Отметка начала вызова API потока для статистики
+typedef struct {
+    double start;
+    AllocStats alloc;
+} StatsMark;
+
+static double stats_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
-    stack->capacity = 16;
-    stack->size = 0;
-    stack->items = (BigNum**)malloc(stack->capacity * sizeof(BigNum*));
-    if (!stack->items) {
-        free(stack);
-        return NULL;
+static StatsMark stats_enter(const RPNStream* stream) {
+    StatsMark mark = { 0, { 0, 0 } };
+    if (stream->stats) {
+        mark.start = stats_clock();
+        mark.alloc = alloc_stats;
+    }
+    return mark;
+}
+
+static void stats_leave(const RPNStream* stream, const StatsMark* mark) {
+    RPNStats* stats = stream->stats;
+    if (stats) {
+        stats->total_seconds += stats_clock() - mark->start;
+        stats->allocations += alloc_stats.count - mark->alloc.count;
+        stats->allocated_bytes += alloc_stats.bytes - mark->alloc.bytes;
     }
+}
 
-    return stack;
+static void* stream_alloc(Arena* arena, size_t size) {
+    return arena ? arena_alloc(arena, size) : counted_malloc(size);
 }
 
-static void stack_free(BigNumStack* stack) {
-    if (stack) {
-        for (size_t i = 0; i < stack->size; i++) {
-            bignum_free(stack->items[i]);
-        }
+static void* stream_realloc(Arena* arena, void* ptr, size_t old_size, size_t new_size) {
+    return arena ? arena_realloc(arena, ptr, old_size, new_size)
+                 : counted_realloc(ptr, new_size);
+}
+
+static bool stack_init(BigNumStack* stack, Arena* arena) {
+    stack->arena = arena;
+    stack->capacity = 16;
+    stack->size = 0;
+    stack->items = (BigNum**)stream_alloc(arena, stack->capacity * sizeof(BigNum*));
+    return stack->items != NULL;
+}
+
+static void stack_destroy(BigNumStack* stack) {
+    for (size_t i = 0; i < stack->size; i++) {
+        bignum_free(stack->items[i]);
+    }
+    if (!stack->arena) {
         free(stack->items);
-        free(stack);
     }
+    stack->items = NULL;
+    stack->size = 0;
 }
 
-static void stack_push(BigNumStack* stack, BigNum* num) {
+static bool stack_push(BigNumStack* stack, BigNum* num) {
     if (stack->size >= stack->capacity) {
-        stack->capacity *= 2;
-        BigNum** new_items = (BigNum**)realloc(stack->items, stack->capacity * sizeof(BigNum*));
-        if (!new_items) return;
+        BigNum** new_items = (BigNum**)stream_realloc(stack->arena, stack->items,
+                                                      stack->capacity * sizeof(BigNum*),
+                                                      2 * stack->capacity * sizeof(BigNum*));
+        if (!new_items) return false;
         stack->items = new_items;
+        stack->capacity *= 2;
     }
     stack->items[stack->size++] = num;
+    return true;
 }
 
 static BigNum* stack_pop(BigNumStack* stack) {
@@ -54,7 +134,7 @@ static size_t stack_size(BigNumStack* stack) {
     return stack->size;
 }
 
-static RPNResult create_error(RPNError code, const char* message, int position) {
+RPNResult rpn_error(RPNError code, const char* message, long long position) {
     RPNResult result;
     result.result = NULL;
     result.error = code;
@@ -63,135 +143,656 @@ static RPNResult create_error(RPNError code, const char* message, int position)
     return result;
 }
 
-static bool is_operator(char c) {
-    return c == '+' || c == '-' || c == '*' || c == '/';
+bool rpn_is_operator(char c) {
+    return c == '+' || c == '-' || c == '*' || c == '/' || c == '%' || c == '^' ||
+           c == '&' || c == ':' || rpn_is_unary(c);
 }
 
-RPNResult rpn_evaluate(const char* expression) {
-    if (!expression) {
-        return create_error(RPN_ERROR_MEMORY, "NULL expression", 0);
+bool rpn_is_unary(char c) {
+    return c == '~' || c == '!';
+}
+
+bool rpn_is_number_char(char c) {
+    return isxdigit((unsigned char)c) || c == 'x' || c == 'X';
+}
+
+// Запоминает первую ошибку; дальнейший текст игнорируется
+static bool stream_fail(RPNStream* stream, RPNError code, const char* message, size_t position) {
+    stream->error = rpn_error(code, message, (long long)position);
+    stream->failed = true;
+    return false;
+}
+
+static bool stream_init(RPNStream* stream, Arena* arena) {
+    memset(stream, 0, sizeof(*stream));
+    stream->arena = arena;
+    stream->state = TOKEN_NONE;
+    return stack_init(&stream->stack, arena);
+}
+
+static void stream_destroy(RPNStream* stream) {
+    stack_destroy(&stream->stack);
+    if (!stream->arena) {
+        free(stream->token);
     }
+    stream->token = NULL;
+    rpn_result_free(&stream->error);
+    stack_destroy(&stream->exponents);
+    bignum_modulus_free(stream->modulus);
+    stream->modulus = NULL;
+}
 
-    BigNumStack* stack = stack_create();
-    if (!stack) {
-        return create_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+static bool token_append(RPNStream* stream, const char* data, size_t size) {
+    size_t need = stream->token_size + size + 1;
+    if (need > stream->token_capacity) {
+        size_t capacity = stream->token_capacity ? stream->token_capacity : 64;
+        while (capacity < need) {
+            capacity *= 2;
+        }
+        char* token = (char*)stream_realloc(stream->arena, stream->token,
+                                            stream->token_capacity, capacity);
+        if (!token) return false;
+        stream->token = token;
+        stream->token_capacity = capacity;
     }
 
-    const char* p = expression;
-    int position = 0;
+    memcpy(stream->token + stream->token_size, data, size);
+    stream->token_size += size;
+    stream->token[stream->token_size] = '\0';
+    return true;
+}
 
-    while (*p) {
-        // Пропуск пробелов
-        while (*p && isspace((unsigned char)*p)) {
-            p++;
-            position++;
+// Кладёт на стек число из len символов text: из буфера лексемы или прямо из куска ввода
+static bool finish_number(RPNStream* stream, const char* text, size_t len) {
+    RPNStats* stats = stream->stats;
+    double start = stats ? stats_clock() : 0;
+    BigNum* num = bignum_from_chars_in(text, len, stream->arena);
+    stream->state = TOKEN_NONE;
+    stream->token_size = 0;
+
+    if (stats && num) {
+        stats->parse_seconds += stats_clock() - start;
+        stats->tokens++;
+        stats->numbers++;
+        stats->number_limbs += arraylist_size(num->digits);
+    }
+
+    if (num && stream->modulus) {
+        // Исходное число остаётся рядом с вычетом: оно может оказаться показателем
+        BigNum* exact = bignum_clone(num);
+        bool ok = exact && stack_push(&stream->exponents, exact);
+        if (!ok) {
+            bignum_free(exact);
         }
+        if (!ok || !bignum_mod_enter(stream->modulus, num, num)) {
+            bignum_free(num);
+            return stream_fail(stream, RPN_ERROR_MEMORY, "Memory allocation failed",
+                               stream->position);
+        }
+    }
 
-        if (!*p) break;
+    if (!num) {
+        char error_msg[100];
+        snprintf(error_msg, sizeof(error_msg), "Invalid number at position %zu", stream->token_start);
+        return stream_fail(stream, RPN_ERROR_INVALID_CHAR, error_msg, stream->token_start);
+    }
 
-        // Проверка на число (может начинаться с '-')
-        if (isdigit((unsigned char)*p) || (*p == '-' && isdigit((unsigned char)*(p + 1)))) {
-            const char* start = p;
-            int num_start = position;
+    if (!stack_push(&stream->stack, num)) {
+        bignum_free(num);
+        return stream_fail(stream, RPN_ERROR_MEMORY, "Memory allocation failed", stream->position);
+    }
+    if (stats && stream->stack.size > stats->peak_depth) {
+        stats->peak_depth = stream->stack.size;
+    }
+    return true;
+}
 
-            // Знак
-            if (*p == '-') {
-                p++;
-                position++;
-            }
+// Модуль числа в uint64; false, если не помещается
+static bool magnitude_u64(const BigNum* num, uint64_t* value) {
+    size_t size = arraylist_size(num->digits);
+    if (size > 2) return false;
+    *value = size == 2 ? (uint64_t)num->digits->data[1] << 32 | num->digits->data[0]
+                       : num->digits->data[0];
+    return true;
+}
 
-            while (*p && isdigit((unsigned char)*p)) {
-                p++;
-                position++;
-            }
-          
-            size_t len = p - start;
-            char* num_str = (char*)malloc(len + 1);
-            if (!num_str) {
-                stack_free(stack);
-                return create_error(RPN_ERROR_MEMORY, "Memory allocation failed", position);
-            }
+// Концы диапазона a..b оператора ':'. Пустой диапазон (a > b) сводится к 1..0,
+// диапазон через ноль — к 0..0, а из отрицательных чисел — к |b|..|a|
+// со знаком минус при нечётной длине. false, если концы длиннее 64 бит.
+static bool range_bounds(const BigNum* a, const BigNum* b, uint64_t* from, uint64_t* to,
+                         bool* negative) {
+    *negative = false;
+    if (bignum_compare(a, b) > 0) {
+        *from = 1;
+        *to = 0;
+        return true;
+    }
+    if (a->is_negative && !b->is_negative) {
+        *from = *to = 0;
+        return true;
+    }
+    if (!a->is_negative) {
+        return magnitude_u64(a, from) && magnitude_u64(b, to);
+    }
+    if (!magnitude_u64(b, from) || !magnitude_u64(a, to)) return false;
+    *negative = ((*to - *from) & 1) == 0;
+    return true;
+}
 
-            strncpy(num_str, start, len);
-            num_str[len] = '\0';
+RPNError rpn_apply(BigNum* dst, const BigNum* a, const BigNum* b, char op,
+                   const char** message) {
+    if ((op == '/' || op == '%') && bignum_is_zero(b)) {
+        *message = "Division by zero";
+        return RPN_ERROR_DIVISION_BY_ZERO;
+    }
 
-            BigNum* num = bignum_from_string(num_str);
-            free(num_str);
+    if (op == '~' && a->is_negative && !bignum_is_zero(a)) {
+        *message = "Square root of negative number";
+        return RPN_ERROR_NEGATIVE_ROOT;
+    }
 
-            if (!num) {
-                stack_free(stack);
-                char error_msg[100];
-                snprintf(error_msg, sizeof(error_msg), "Invalid number at position %d", num_start);
-                return create_error(RPN_ERROR_INVALID_CHAR, error_msg, num_start);
-            }
+    // Диапазон произведения: n! — это 1..n
+    uint64_t from = 1, to = 0;
+    bool negative_range = false;
+    if (op == '!') {
+        if (a->is_negative && !bignum_is_zero(a)) {
+            *message = "Factorial of negative number";
+            return RPN_ERROR_NEGATIVE_FACTORIAL;
+        }
+        if (!bignum_to_uint64(a, &to) || bignum_product_range_size(1, to) > BIGNUM_MAX_LIMBS) {
+            *message = "Factorial argument too large";
+            return RPN_ERROR_TOO_LARGE;
+        }
+    }
+    if (op == ':' && (!range_bounds(a, b, &from, &to, &negative_range) ||
+                      bignum_product_range_size(from, to) > BIGNUM_MAX_LIMBS)) {
+        *message = "Range bounds too large";
+        return RPN_ERROR_TOO_LARGE;
+    }
 
-            stack_push(stack, num);
-        } else if (is_operator(*p)) {
-            char op = *p;
-            int op_position = position;
-          
-            if (op == '/') {
-                stack_free(stack);
-                return create_error(RPN_ERROR_UNSUPPORTED_OP, "Unsupported operation", op_position);
+    uint64_t exponent = 0;
+    if (op == '^') {
+        if (b->is_negative && !bignum_is_zero(b)) {
+            *message = "Negative exponent";
+            return RPN_ERROR_NEGATIVE_EXPONENT;
+        }
+        // Огромный показатель допустим только для оснований 0 и ±1: знак решает чётность
+        if (!bignum_to_uint64(b, &exponent)) {
+            if (arraylist_size(a->digits) > 1 || a->digits->data[0] > 1) {
+                *message = "Exponent too large";
+                return RPN_ERROR_TOO_LARGE;
             }
+            exponent = 2 | (b->digits->data[0] & 1);
+        }
+        if (bignum_pow_size(a, exponent) > BIGNUM_MAX_LIMBS) {
+            *message = "Exponent too large";
+            return RPN_ERROR_TOO_LARGE;
+        }
+    }
 
-            if (stack_size(stack) < 2) {
-                stack_free(stack);
-                return create_error(RPN_ERROR_INSUFFICIENT_OPERANDS, "Insufficient operands for operation", op_position);
+    bool ok = true;
+    switch (op) {
+        case '+':
+            ok = bignum_add_into(dst, a, b);
+            break;
+        case '-':
+            ok = bignum_subtract_into(dst, a, b);
+            break;
+        case '*':
+            ok = bignum_multiply_into(dst, a, b);
+            break;
+        case '^':
+            ok = bignum_pow_into(dst, a, exponent);
+            break;
+        case '&':
+            ok = bignum_gcd_into(dst, a, b);
+            break;
+        case '~':
+            ok = bignum_isqrt_into(dst, a);
+            break;
+        case '!':
+        case ':':
+            ok = bignum_product_range_into(dst, from, to);
+            if (ok && negative_range) {
+                dst->is_negative = !bignum_is_zero(dst);
             }
+            break;
+        case '/':
+            ok = bignum_divmod_into(dst, NULL, a, b);
+            break;
+        case '%':
+            ok = bignum_divmod_into(NULL, dst, a, b);
+            break;
+    }
+
+    if (!ok) {
+        *message = "Memory allocation failed during operation";
+        return RPN_ERROR_MEMORY;
+    }
+    return RPN_OK;
+}
 
-            BigNum* b = stack_pop(stack);
-            BigNum* a = stack_pop(stack);
-            BigNum* result = NULL;
-
-            switch (op) {
-                case '+':
-                    result = bignum_add(a, b);
-                    break;
-                case '-':
-                    result = bignum_subtract(a, b);
-                    break;
-                case '*':
-                    result = bignum_multiply(a, b);
-                    break;
+// Оператор в модульном режиме: на стеке вычеты во внутренней форме.
+// exponent — исходное значение правого операнда, NULL у результата операции.
+static RPNError apply_mod(const BigNumModulus* mod, BigNum* a, const BigNum* b,
+                          const BigNum* exponent, char op, const char** message) {
+    bool ok = true;
+    switch (op) {
+        case '+':
+            ok = bignum_mod_add_into(mod, a, a, b);
+            break;
+        case '-':
+            ok = bignum_mod_subtract_into(mod, a, a, b);
+            break;
+        case '*':
+            ok = bignum_mod_multiply_into(mod, a, a, b);
+            break;
+        case '^':
+            // Показатель — само число, а не вычет: a^e и a^(e mod m) различаются.
+            // У результата операции есть только вычет, поэтому показателем может
+            // быть лишь число из текста
+            if (!exponent) {
+                *message = "Exponent must be a number in modular mode";
+                return RPN_ERROR_UNSUPPORTED_OP;
+            }
+            if (exponent->is_negative && !bignum_is_zero(exponent)) {
+                *message = "Negative exponent";
+                return RPN_ERROR_NEGATIVE_EXPONENT;
             }
+            ok = bignum_mod_pow_into(mod, a, a, exponent);
+            break;
+        default:
+            *message = "Operator is not supported in modular mode";
+            return RPN_ERROR_UNSUPPORTED_OP;
+    }
+
+    if (!ok) {
+        *message = "Memory allocation failed during operation";
+        return RPN_ERROR_MEMORY;
+    }
+    return RPN_OK;
+}
+
+static bool apply_operator(RPNStream* stream, char op, size_t op_position) {
+    BigNumStack* stack = &stream->stack;
+    size_t arity = rpn_is_unary(op) ? 1 : 2;
+
+    if (stack_size(stack) < arity) {
+        return stream_fail(stream, RPN_ERROR_INSUFFICIENT_OPERANDS,
+                           "Insufficient operands for operation", op_position);
+    }
+
+    // Операнды остаются на стеке до успешного конца операции: при ошибке их освободит стек.
+    // Результат пишется на место левого операнда: его разряды переиспользуются.
+    BigNum* b = arity == 2 ? stack->items[stack->size - 1] : NULL;
+    BigNum* a = stack->items[stack->size - arity];
+
+    RPNStats* stats = stream->stats;
+    RPNOperatorStats* op_stats = NULL;
+    double start = 0;
+    if (stats) {
+        op_stats = &stats->operators[strchr(RPN_STATS_OPERATORS, op) - RPN_STATS_OPERATORS];
+        op_stats->calls++;
+        op_stats->limbs += arraylist_size(a->digits) + (b ? arraylist_size(b->digits) : 0);
+        stats->tokens++;
+        start = stats_clock();
+    }
+
+    const char* message;
+    RPNError code;
+    if (stream->modulus) {
+        BigNumStack* exponents = &stream->exponents;
+        code = apply_mod(stream->modulus, a, b, b ? exponents->items[exponents->size - 1] : NULL,
+                         op, &message);
+    } else {
+        code = rpn_cache_apply(stream->cache, a, a, b, op, &message);
+    }
+    if (op_stats) {
+        op_stats->seconds += stats_clock() - start;
+    }
+    if (code != RPN_OK) {
+        return stream_fail(stream, code, message, op_position);
+    }
+
+    if (b) {
+        bignum_free(stack_pop(stack));
+    }
+    if (stream->modulus) {
+        // У результата на месте a исходного числа больше нет
+        BigNumStack* exponents = &stream->exponents;
+        if (b) {
+            bignum_free(stack_pop(exponents));
+        }
+        bignum_free(exponents->items[exponents->size - 1]);
+        exponents->items[exponents->size - 1] = NULL;
+    }
+    return true;
+}
+
+// Завершает лексему, ожидавшую следующего символа (или конца текста)
+static bool finish_token(RPNStream* stream) {
+    switch (stream->state) {
+        case TOKEN_NUMBER:
+            return finish_number(stream, stream->token, stream->token_size);
+        case TOKEN_MINUS:
+            stream->state = TOKEN_NONE;
+            return apply_operator(stream, '-', stream->token_start);
+        case TOKEN_NONE:
+            break;
+    }
+    return true;
+}
 
-            bignum_free(a);
-            bignum_free(b);
+static bool stream_feed(RPNStream* stream, const char* data, size_t size) {
+    const char* p = data;
+    const char* end = data + size;
+    // Начало текущего числа, если оно началось в этом куске. Число, целиком
+    // лежащее в куске, разбирается на месте; в буфер лексемы копируется только
+    // число, разорванное границей куска.
+    const char* number = NULL;
+
+    while (!stream->failed && p < end) {
+        if (stream->state == TOKEN_NUMBER) {
+            // Символы числа до конца куска или до первого постороннего символа
+            const char* start = p;
+            while (p < end && rpn_is_number_char(*p)) {
+                p++;
+            }
+            stream->position += p - start;
+
+            if (number && p < end) {
+                finish_number(stream, number, p - number);
+            } else {
+                const char* from = number ? number : start;
+                if (p > from && !token_append(stream, from, p - from)) {
+                    return stream_fail(stream, RPN_ERROR_MEMORY, "Memory allocation failed",
+                                       stream->position);
+                }
+                if (p < end) {
+                    finish_number(stream, stream->token, stream->token_size);
+                }
+            }
+            number = NULL;
+            continue;
+        }
 
-            if (!result) {
-                stack_free(stack);
-                return create_error(RPN_ERROR_MEMORY, "Memory allocation failed during operation", op_position);
+        char c = *p;
+
+        if (stream->state == TOKEN_MINUS) {
+            if (isdigit((unsigned char)c)) {
+                // Отрицательное число; минус остался в прошлом куске — копируем его
+                stream->state = TOKEN_NUMBER;
+                if (p > data) {
+                    number = p - 1;
+                } else if (!token_append(stream, "-", 1)) {
+                    return stream_fail(stream, RPN_ERROR_MEMORY, "Memory allocation failed",
+                                       stream->position);
+                }
+            } else {
+                finish_token(stream);
             }
+            continue;
+        }
 
-            stack_push(stack, result);
+        // Между лексемами
+        if (isspace((unsigned char)c)) {
             p++;
-            position++;
+            stream->position++;
+        } else if (isdigit((unsigned char)c)) {
+            stream->state = TOKEN_NUMBER;
+            stream->token_start = stream->position;
+            number = p;
+        } else if (c == '-') {
+            stream->state = TOKEN_MINUS;
+            stream->token_start = stream->position;
+            p++;
+            stream->position++;
+        } else if (rpn_is_operator(c)) {
+            apply_operator(stream, c, stream->position);
+            p++;
+            stream->position++;
         } else {
-            stack_free(stack);
             char error_msg[100];
-            snprintf(error_msg, sizeof(error_msg), "Invalid character at position %d", position);
-            return create_error(RPN_ERROR_INVALID_CHAR, error_msg, position);
+            snprintf(error_msg, sizeof(error_msg), "Invalid character at position %zu",
+                     stream->position);
+            return stream_fail(stream, RPN_ERROR_INVALID_CHAR, error_msg, stream->position);
         }
     }
 
+    return !stream->failed;
+}
+
+static RPNResult stream_result(RPNStream* stream) {
+    if (!stream->failed) {
+        finish_token(stream);
+    }
+    if (stream->failed) {
+        RPNResult error = stream->error;
+        stream->error.error_message = NULL;
+        return error;
+    }
+
+    BigNumStack* stack = &stream->stack;
     if (stack_size(stack) == 0) {
-        stack_free(stack);
-        return create_error(RPN_ERROR_INSUFFICIENT_OPERANDS, "No result", 0);
+        return rpn_error(RPN_ERROR_INSUFFICIENT_OPERANDS, "No result", 0);
     }
 
     if (stack_size(stack) > 1) {
-        stack_free(stack);
-        return create_error(RPN_ERROR_MISSING_OP, "Operation symbol is missed", 0);
+        return rpn_error(RPN_ERROR_MISSING_OP, "Operation symbol is missed", 0);
     }
 
+    // Из арены ответ выносится в кучу, всё остальное уйдёт с arena_reset
     RPNResult result;
-    result.result = stack_pop(stack);
+    BigNum* top = stack_pop(stack);
+    if (stream->modulus && !bignum_mod_leave(stream->modulus, top, top)) {
+        bignum_free(top);
+        return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
+    result.result = stream->arena ? bignum_clone(top) : top;
+    if (!result.result) {
+        return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
     result.error = RPN_OK;
     result.error_message = NULL;
     result.error_position = -1;
+    return result;
+}
+
+static RPNResult evaluate(const char* expression, Arena* arena, RPNCache* cache) {
+    RPNStream stream;
+    RPNResult result;
+
+    if (!stream_init(&stream, arena)) {
+        result = rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    } else {
+        stream.cache = cache;
+        stream_feed(&stream, expression, strlen(expression));
+        result = stream_result(&stream);
+    }
+
+    stream_destroy(&stream);
+    return result;
+}
+
+RPNResult rpn_evaluate_in(const char* expression, Arena* arena) {
+    if (!expression) {
+        return rpn_error(RPN_ERROR_MEMORY, "NULL expression", 0);
+    }
+    if (!arena) {
+        return rpn_evaluate(expression);
+    }
+
+    RPNResult result = evaluate(expression, arena, NULL);
+    arena_reset(arena);
+    return result;
+}
+
+RPNResult rpn_evaluate(const char* expression) {
+    return rpn_evaluate_cached(expression, NULL);
+}
+
+RPNResult rpn_evaluate_cached(const char* expression, RPNCache* cache) {
+    if (!expression) {
+        return rpn_error(RPN_ERROR_MEMORY, "NULL expression", 0);
+    }
+
+    Arena* arena = arena_create();
+    if (!arena) {
+        return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
+
+    RPNResult result = evaluate(expression, arena, cache);
+    arena_destroy(arena);
+    return result;
+}
+
+RPNStream* rpn_stream_create(void) {
+    RPNStream* stream = (RPNStream*)counted_malloc(sizeof(RPNStream));
+    if (!stream) return NULL;
+
+    if (!stream_init(stream, NULL)) {
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+void rpn_stream_set_cache(RPNStream* stream, RPNCache* cache) {
+    stream->cache = cache;
+}
+
+bool rpn_stream_set_modulus(RPNStream* stream, const BigNum* modulus) {
+    if (stream->failed) return false;
+    if (!modulus || modulus->is_negative || bignum_is_zero(modulus)) {
+        return stream_fail(stream, RPN_ERROR_INVALID_CHAR, "Modulus must be positive", 0);
+    }
+    if (stream->position > 0) {
+        return stream_fail(stream, RPN_ERROR_UNSUPPORTED_OP,
+                           "Modulus must be set before the expression", 0);
+    }
+
+    bignum_modulus_free(stream->modulus);
+    stream->modulus = bignum_modulus_create(modulus);
+    if (!stream->modulus || (!stream->exponents.items &&
+                             !stack_init(&stream->exponents, stream->arena))) {
+        return stream_fail(stream, RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
+    return true;
+}
+
+RPNResult rpn_evaluate_mod(const char* expression, const BigNum* modulus) {
+    if (!expression) {
+        return rpn_error(RPN_ERROR_MEMORY, "NULL expression", 0);
+    }
+
+    RPNStream* stream = rpn_stream_create();
+    if (!stream) {
+        return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
+
+    // Ошибку модуля вернёт rpn_stream_finish
+    if (rpn_stream_set_modulus(stream, modulus)) {
+        rpn_stream_feed(stream, expression, strlen(expression));
+    }
+    RPNResult result = rpn_stream_finish(stream);
+    rpn_stream_free(stream);
+    return result;
+}
+
+void rpn_stream_set_stats(RPNStream* stream, RPNStats* stats) {
+    stream->stats = stats;
+}
+
+bool rpn_stream_feed(RPNStream* stream, const char* data, size_t size) {
+    StatsMark mark = stats_enter(stream);
+    bool ok = stream_feed(stream, data, size);
+    stats_leave(stream, &mark);
+    return ok;
+}
+
+RPNResult rpn_stream_finish(RPNStream* stream) {
+    StatsMark mark = stats_enter(stream);
+    RPNResult result = stream_result(stream);
+    stats_leave(stream, &mark);
+    return result;
+}
+
+void rpn_stream_free(RPNStream* stream) {
+    if (stream) {
+        stream_destroy(stream);
+        free(stream);
+    }
+}
+
+// Обычный файл целиком отображается в память и разбирается без копирования
+static bool feed_mapped(RPNStream* stream, FILE* file) {
+    struct stat st;
+    int fd = fileno(file);
+    off_t offset = ftello(file);
+    if (fd < 0 || offset < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_size <= offset || (uint64_t)st.st_size > SIZE_MAX) {
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) return false;
+
+    // Разбираем окнами и отдаём прочитанные страницы системе, чтобы
+    // многогигабайтный файл не копился в резидентной памяти
+    madvise(data, size, MADV_SEQUENTIAL);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t done = (size_t)offset;
+    while (done < size && !stream->failed) {
+        size_t window = size - done < STREAM_MAP_WINDOW ? size - done : STREAM_MAP_WINDOW;
+        stream_feed(stream, (const char*)data + done, window);
+        done += window;
+        madvise(data, done / page * page, MADV_DONTNEED);
+    }
+    munmap(data, size);
+    fseeko(file, st.st_size, SEEK_SET);
+    return true;
+}
+
+static bool feed_file(RPNStream* stream, FILE* file) {
+    if (feed_mapped(stream, file)) {
+        return !stream->failed;
+    }
+
+    char* chunk = (char*)counted_malloc(STREAM_CHUNK_SIZE);
+    if (!chunk) {
+        return stream_fail(stream, RPN_ERROR_MEMORY, "Memory allocation failed", stream->position);
+    }
+
+    size_t got;
+    while ((got = fread(chunk, 1, STREAM_CHUNK_SIZE, file)) > 0) {
+        if (!stream_feed(stream, chunk, got)) break;
+    }
+    free(chunk);
+    return !stream->failed;
+}
+
+bool rpn_stream_feed_file(RPNStream* stream, FILE* file) {
+    StatsMark mark = stats_enter(stream);
+    bool ok = feed_file(stream, file);
+    stats_leave(stream, &mark);
+    return ok;
+}
+
+RPNResult rpn_evaluate_file(FILE* file) {
+    return rpn_evaluate_file_cached(file, NULL);
+}
+
+RPNResult rpn_evaluate_file_cached(FILE* file, RPNCache* cache) {
+    RPNStream* stream = rpn_stream_create();
+    if (!stream) {
+        return rpn_error(RPN_ERROR_MEMORY, "Memory allocation failed", 0);
+    }
+    stream->cache = cache;
 
-    stack_free(stack);
+    rpn_stream_feed_file(stream, file);
+    RPNResult result = rpn_stream_finish(stream);
+    rpn_stream_free(stream);
     return result;
 }
 
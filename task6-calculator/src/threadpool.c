@@ -0,0 +1,142 @@
+#include "threadpool.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+struct ThreadPool {
+    pthread_t* workers;
+    size_t worker_count;
+
+    pthread_mutex_t busy;  // Захвачен на время одного задания
+
+    pthread_mutex_t lock;  // Защищает поля ниже
+    pthread_cond_t wake;   // Появилось задание или пора завершаться
+    pthread_cond_t done;   // Все индексы задания обработаны
+    void (*fn)(void* ctx, size_t index);
+    void* ctx;
+    size_t count;
+    size_t next;           // Следующий свободный индекс
+    size_t finished;       // Сколько индексов обработано
+    unsigned long generation;
+    bool stop;
+};
+
+// Забирает индексы текущего задания, пока они есть. Вызывается под lock.
+static void run_indices(ThreadPool* pool) {
+    while (pool->next < pool->count) {
+        size_t index = pool->next++;
+        void (*fn)(void*, size_t) = pool->fn;
+        void* ctx = pool->ctx;
+
+        pthread_mutex_unlock(&pool->lock);
+        fn(ctx, index);
+        pthread_mutex_lock(&pool->lock);
+
+        if (++pool->finished == pool->count) {
+            pthread_cond_broadcast(&pool->done);
+        }
+    }
+}
+
+static void* worker_main(void* arg) {
+    ThreadPool* pool = (ThreadPool*)arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop) break;
+
+        seen = pool->generation;
+        run_indices(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool* threadpool_create(size_t threads) {
+    if (threads < 1) return NULL;
+
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+
+    pool->worker_count = threads - 1;
+    pool->workers = (pthread_t*)malloc((pool->worker_count + 1) * sizeof(pthread_t));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->busy, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t i = 0; i < pool->worker_count; i++) {
+        if (pthread_create(&pool->workers[i], NULL, worker_main, pool) != 0) {
+            // Работаем с теми потоками, что успели создаться
+            pool->worker_count = i;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+void threadpool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->worker_count; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->busy);
+    free(pool->workers);
+    free(pool);
+}
+
+size_t threadpool_size(const ThreadPool* pool) {
+    return pool ? pool->worker_count + 1 : 1;
+}
+
+void threadpool_for(ThreadPool* pool, void (*fn)(void* ctx, size_t index), void* ctx,
+                    size_t count) {
+    if (!pool || pool->worker_count == 0 || count < 2 ||
+        pthread_mutex_trylock(&pool->busy) != 0) {
+        for (size_t i = 0; i < count; i++) {
+            fn(ctx, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->count = count;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+
+    run_indices(pool);
+    while (pool->finished < pool->count) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+
+    // Обнуляем задание, чтобы поздно проснувшийся рабочий не взял старые индексы
+    pool->count = 0;
+    pool->next = 0;
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->busy);
+}
@@ -0,0 +1,179 @@
+#include "bignum_internal.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Деление с остатком (Кнут D, Burnikel–Ziegler, в том числе с ответом поверх
+// операндов), обратное число Ньютона и редукция Барретта: длины по обе стороны
+// от порогов переключения, все знаки и делители со старшим разрядом 1 и
+// 0xffffffff (крайние случаи нормализации)
+
+static int failures = 0;
+
+static uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+typedef enum { FILL_RANDOM, FILL_ONES, FILL_ZEROS } Fill;
+
+// Число из limbs разрядов со старшим разрядом top (0 — случайный ненулевой)
+static BigNum* make_bignum(size_t limbs, uint32_t top, Fill fill, bool negative,
+                           uint64_t* state) {
+    BigNum* num = bignum_create();
+    arraylist_resize(num->digits, limbs);
+    for (size_t i = 0; i < limbs; i++) {
+        uint32_t limb = (uint32_t)(xorshift64(state) >> 32);
+        num->digits->data[i] = fill == FILL_ONES ? UINT32_MAX : fill == FILL_ZEROS ? 0 : limb;
+    }
+    num->digits->data[limbs - 1] = top ? top : num->digits->data[limbs - 1] | 1;
+    num->is_negative = negative;
+    return num;
+}
+
+// BASE^k
+static BigNum* limbs_power(size_t k) {
+    BigNum* num = bignum_create();
+    arraylist_resize(num->digits, k + 1);
+    num->digits->data[k] = 1;
+    return num;
+}
+
+// q * b + r == a, |r| < |b|; частное к нулю, остаток со знаком делимого
+static bool valid_divmod(const BigNum* a, const BigNum* b, const BigNum* q, const BigNum* r) {
+    BigNum* t = bignum_multiply(q, b);
+    bignum_add_into(t, t, r);
+    bool ok = bignum_compare(t, a) == 0 && bignum_compare_abs(r, b) < 0 &&
+              (bignum_is_zero(r) || r->is_negative == a->is_negative) &&
+              (bignum_is_zero(q) || q->is_negative == (a->is_negative != b->is_negative));
+    bignum_free(t);
+    return ok;
+}
+
+// bignum_divmod_into с ответом поверх операндов: 0 — q = a, 1 — r = a, 2 — q = b, r = a,
+// 3 — q = a, r = b, 4 — только q = a, 5 — только r = b
+static void check_into(const BigNum* a, const BigNum* b, const BigNum* q, const BigNum* r) {
+    for (int mode = 0; mode < 6; mode++) {
+        BigNum* x = bignum_clone(a);
+        BigNum* y = bignum_clone(b);
+        BigNum* other = bignum_create();
+        BigNum* quotient = mode == 0 || mode == 3 || mode == 4 ? x : mode == 2 ? y : other;
+        BigNum* remainder = mode == 1 || mode == 2 ? x : mode == 3 || mode == 5 ? y : other;
+        if (mode == 4) remainder = NULL;
+        if (mode == 5) quotient = NULL;
+
+        if (!bignum_divmod_into(quotient, remainder, x, y) ||
+            (quotient && bignum_compare(quotient, q) != 0) ||
+            (remainder && bignum_compare(remainder, r) != 0)) {
+            fprintf(stderr, "FAIL: divmod_into mode %d, %zu / %zu limbs\n", mode,
+                    arraylist_size(a->digits), arraylist_size(b->digits));
+            failures++;
+        }
+
+        bignum_free(other);
+        bignum_free(y);
+        bignum_free(x);
+    }
+}
+
+static void check_divmod(size_t an, size_t bn, uint32_t top, Fill fill, uint64_t* state) {
+    for (int signs = 0; signs < 4; signs++) {
+        BigNum* a = make_bignum(an, 0, fill, signs & 1, state);
+        BigNum* b = make_bignum(bn, top, fill, signs & 2, state);
+        BigNum* q = NULL;
+        BigNum* r = NULL;
+
+        if (!bignum_divmod(a, b, &q, &r) || !valid_divmod(a, b, q, r)) {
+            fprintf(stderr, "FAIL: divmod %s%zu / %s%zu limbs, top %#x, fill %d\n",
+                    a->is_negative ? "-" : "", an, b->is_negative ? "-" : "", bn, top, fill);
+            failures++;
+        } else {
+            check_into(a, b, q, r);
+        }
+
+        bignum_free(q);
+        bignum_free(r);
+        bignum_free(b);
+        bignum_free(a);
+    }
+}
+
+// inv * d <= BASE^(2n) < (inv + 1) * d, затем деление Барретта по этому inv
+static void check_reciprocal(size_t n, uint32_t top, Fill fill, uint64_t* state) {
+    BigNum* d = make_bignum(n, top, fill, false, state);
+    BigNum* inv = bignum_reciprocal(d);
+    BigNum* unit = limbs_power(2 * n);
+    BigNum* one = bignum_from_int(1);
+
+    BigNum* low = inv ? bignum_multiply(inv, d) : NULL;
+    BigNum* high = low ? bignum_add(low, d) : NULL;
+    if (!high || bignum_compare(low, unit) > 0 || bignum_compare(high, unit) <= 0) {
+        fprintf(stderr, "FAIL: reciprocal of %zu limbs, top %#x, fill %d\n", n, top, fill);
+        failures++;
+    }
+
+    // Делимые до BASE^(2n) - 1 включительно
+    for (int i = 0; inv && i < 4; i++) {
+        BigNum* x = i == 3 ? bignum_subtract(unit, one)
+                           : make_bignum(n + (size_t)i * n / 2, 0, FILL_RANDOM, false, state);
+        BigNum* q = NULL;
+        BigNum* r = NULL;
+        if (!bignum_divmod_reciprocal(x, d, inv, &q, &r) || !valid_divmod(x, d, q, r)) {
+            fprintf(stderr, "FAIL: Barrett %zu / %zu limbs, top %#x, fill %d\n",
+                    arraylist_size(x->digits), n, top, fill);
+            failures++;
+        }
+        bignum_free(q);
+        bignum_free(r);
+        bignum_free(x);
+    }
+
+    bignum_free(high);
+    bignum_free(low);
+    bignum_free(one);
+    bignum_free(unit);
+    bignum_free(inv);
+    bignum_free(d);
+}
+
+int main(void) {
+    uint64_t state = 0x2545f4914f6cdd1dull;
+    static const uint32_t tops[] = { 0, 1, UINT32_MAX };
+    static const Fill fills[] = { FILL_RANDOM, FILL_ONES, FILL_ZEROS };
+
+    // Деление переходит к Burnikel–Ziegler с делителя в 160 разрядов, если
+    // делимое длиннее делителя ещё хотя бы на 160 разрядов
+    static const size_t divisors[] = { 1, 2, 3, 17, 159, 160, 161, 400 };
+    for (size_t i = 0; i < sizeof(divisors) / sizeof(divisors[0]); i++) {
+        size_t bn = divisors[i];
+        const size_t dividends[] = { bn > 1 ? bn - 1 : 1, bn, bn + 1, bn + 159, bn + 160,
+                                     2 * bn + 1, 4 * bn + 3 };
+        for (size_t j = 0; j < sizeof(dividends) / sizeof(dividends[0]); j++) {
+            for (size_t t = 0; t < sizeof(tops) / sizeof(tops[0]); t++) {
+                for (size_t f = 0; f < sizeof(fills) / sizeof(fills[0]); f++) {
+                    check_divmod(dividends[j], bn, tops[t], fills[f], &state);
+                }
+            }
+        }
+    }
+
+    // Обратное число: прямое деление до 64 разрядов, дальше шаг Ньютона
+    // (рекурсивно, так что длинные делители проходят через оба пути)
+    static const size_t lengths[] = { 1, 2, 63, 64, 65, 66, 129, 130, 500, 2001 };
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        for (size_t t = 0; t < sizeof(tops) / sizeof(tops[0]); t++) {
+            for (size_t f = 0; f < sizeof(fills) / sizeof(fills[0]); f++) {
+                check_reciprocal(lengths[i], tops[t], fills[f], &state);
+            }
+        }
+    }
+
+    if (failures) {
+        fprintf(stderr, "%d failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
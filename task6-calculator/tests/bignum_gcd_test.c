@@ -0,0 +1,175 @@
+#include "bignum.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// НОД на длинах выше порога половинного НОД (4096 разрядов) против алгоритма
+// Евклида, а там, где Евклид слишком долог, — против известного ответа:
+// НОД(F(m), F(n)) = F(НОД(m, n)) для чисел Фибоначчи, у соседних он равен 1
+
+static int failures = 0;
+
+static uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static BigNum* random_bignum(size_t limbs, bool negative, uint64_t* state) {
+    BigNum* num = bignum_create();
+    arraylist_resize(num->digits, limbs);
+    for (size_t i = 0; i < limbs; i++) {
+        num->digits->data[i] = (uint32_t)(xorshift64(state) >> 32);
+    }
+    num->digits->data[limbs - 1] |= 1;
+    num->is_negative = negative;
+    return num;
+}
+
+// Алгоритм Евклида на остатках
+static BigNum* euclid(const BigNum* x, const BigNum* y) {
+    BigNum* a = bignum_clone(x);
+    BigNum* b = bignum_clone(y);
+    BigNum* r = bignum_create();
+    a->is_negative = b->is_negative = false;
+
+    while (!bignum_is_zero(b)) {
+        bignum_divmod_into(NULL, r, a, b);
+        BigNum* t = a;
+        a = b;
+        b = r;
+        r = t;
+    }
+
+    bignum_free(b);
+    bignum_free(r);
+    return a;
+}
+
+// F(k) удвоением: F(2j) = F(j)(2F(j+1) - F(j)), F(2j+1) = F(j)^2 + F(j+1)^2
+static BigNum* fibonacci(uint64_t k) {
+    BigNum* f = bignum_from_int(0);
+    BigNum* g = bignum_from_int(1);
+    BigNum* t = bignum_create();
+    BigNum* u = bignum_create();
+
+    for (int bit = 63; bit >= 0; bit--) {
+        // (f, g) = (F(j), F(j+1)) -> (F(2j), F(2j+1))
+        bignum_add_into(t, g, g);
+        bignum_subtract_into(t, t, f);
+        bignum_multiply_into(t, t, f);
+        bignum_square_into(u, f);
+        bignum_square_into(g, g);
+        bignum_add_into(g, g, u);
+        bignum_assign(f, t);
+
+        if ((k >> bit) & 1) {
+            bignum_add_into(t, f, g);
+            bignum_assign(f, g);
+            bignum_assign(g, t);
+        }
+    }
+
+    bignum_free(g);
+    bignum_free(t);
+    bignum_free(u);
+    return f;
+}
+
+static void check(const char* name, const BigNum* a, const BigNum* b, const BigNum* expected) {
+    BigNum* g = bignum_gcd(a, b);
+    BigNum* dst = bignum_clone(a);
+    bignum_gcd_into(dst, dst, b);
+
+    if (!g || bignum_compare(g, expected) != 0 || bignum_compare(dst, expected) != 0) {
+        fprintf(stderr, "FAIL: %s (%zu and %zu limbs)\n", name, arraylist_size(a->digits),
+                arraylist_size(b->digits));
+        failures++;
+    }
+
+    bignum_free(dst);
+    bignum_free(g);
+}
+
+static void check_euclid(const char* name, const BigNum* a, const BigNum* b) {
+    BigNum* expected = euclid(a, b);
+    check(name, a, b, expected);
+    bignum_free(expected);
+}
+
+int main(void) {
+    uint64_t state = 0x853c49e6748fea9bull;
+
+    // Случайная пара (почти всегда с малым НОД) со всеми знаками
+    BigNum* a = random_bignum(4500, false, &state);
+    BigNum* b = random_bignum(4200, false, &state);
+    BigNum* expected = euclid(a, b);
+    for (int signs = 0; signs < 4; signs++) {
+        a->is_negative = signs & 1;
+        b->is_negative = signs & 2;
+        check("random", a, b, expected);
+    }
+    bignum_free(expected);
+    bignum_free(b);
+    bignum_free(a);
+
+    // Общий множитель в треть длины
+    BigNum* common = random_bignum(1500, false, &state);
+    BigNum* u = random_bignum(3000, false, &state);
+    BigNum* v = random_bignum(2900, true, &state);
+    bignum_multiply_into(u, u, common);
+    bignum_multiply_into(v, v, common);
+    check_euclid("common factor", u, v);
+
+    // Взаимно простые: нечётное число и степень двойки, соседние числа
+    BigNum* two = bignum_from_int(2);
+    BigNum* power = bignum_pow(two, 140000);
+    BigNum* one = bignum_from_int(1);
+    BigNum* odd = random_bignum(4400, false, &state);
+    odd->digits->data[0] |= 1;
+    check("odd and power of two", odd, power, one);
+    BigNum* next = bignum_add(odd, one);
+    check("consecutive", next, odd, one);
+
+    // Равные операнды и нулевой операнд
+    BigNum* zero = bignum_create();
+    BigNum* negative = bignum_clone(u);
+    negative->is_negative = true;
+    check("equal", u, u, u);
+    check("opposite", negative, u, u);
+    check("zero right", negative, zero, u);
+    check("zero left", zero, u, u);
+
+    // Соседние числа Фибоначчи — худший случай для цепочки частных (все равны 1)
+    BigNum* f100k = fibonacci(100000);
+    BigNum* f200k = fibonacci(200000);
+    BigNum* f200k1 = fibonacci(200001);
+    BigNum* f300k = fibonacci(300000);
+    check("consecutive Fibonacci", f200k1, f200k, one);
+    f200k->is_negative = true;
+    check("consecutive Fibonacci, negative", f200k, f200k1, one);
+    check("Fibonacci F(200000), F(300000)", f300k, f200k, f100k);
+
+    bignum_free(f100k);
+    bignum_free(f200k);
+    bignum_free(f200k1);
+    bignum_free(f300k);
+    bignum_free(negative);
+    bignum_free(zero);
+    bignum_free(next);
+    bignum_free(odd);
+    bignum_free(one);
+    bignum_free(power);
+    bignum_free(two);
+    bignum_free(v);
+    bignum_free(u);
+    bignum_free(common);
+
+    if (failures) {
+        fprintf(stderr, "%d failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "bignum.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Каждый уровень умножения (Карацуба, Тоом-3, NTT, NTT в потоках) сверяется
+// со школьным: уровни включаются порогами на малых длинах, а на порогах по
+// умолчанию проверяются длины по обе стороны от каждого порога
+
+static int failures = 0;
+
+static const BigNumMulThresholds schoolbook = { SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX };
+
+static uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// Случайное число из limbs разрядов со случайным знаком; при ones все разряды
+// 0xffffffff — самые длинные цепочки переносов
+static BigNum* random_bignum(size_t limbs, bool ones, uint64_t* state) {
+    BigNum* num = bignum_create();
+    arraylist_resize(num->digits, limbs);
+    for (size_t i = 0; i < limbs; i++) {
+        num->digits->data[i] = ones ? UINT32_MAX : (uint32_t)(xorshift64(state) >> 32);
+    }
+    num->digits->data[limbs - 1] |= 1;
+    num->is_negative = xorshift64(state) & 1;
+    return num;
+}
+
+static BigNum* reference(const BigNum* a, const BigNum* b) {
+    BigNumMulThresholds saved = bignum_get_mul_thresholds();
+    bignum_set_mul_thresholds(&schoolbook);
+    BigNum* product = bignum_multiply(a, b);
+    bignum_set_mul_thresholds(&saved);
+    return product;
+}
+
+static void expect(const BigNum* got, const BigNum* expected, const char* tier, const char* call,
+                   size_t an, size_t bn) {
+    if (bignum_compare(got, expected) != 0) {
+        fprintf(stderr, "FAIL: %s, %s, %zu x %zu limbs\n", tier, call, an, bn);
+        failures++;
+    }
+}
+
+// a·b и все варианты с совпадающими аргументами _into
+static void check(const char* tier, size_t an, size_t bn, bool ones, uint64_t* state) {
+    BigNum* a = random_bignum(an, ones, state);
+    BigNum* b = random_bignum(bn, ones, state);
+    BigNum* expected = reference(a, b);
+    BigNum* square = reference(a, a);
+
+    BigNum* product = bignum_multiply(a, b);
+    expect(product, expected, tier, "a * b", an, bn);
+
+    BigNum* dst = bignum_clone(a);
+    bignum_multiply_into(dst, dst, b);
+    expect(dst, expected, tier, "a = a * b", an, bn);
+
+    bignum_assign(dst, b);
+    bignum_multiply_into(dst, a, dst);
+    expect(dst, expected, tier, "b = a * b", an, bn);
+
+    bignum_assign(dst, a);
+    bignum_multiply_into(dst, dst, dst);
+    expect(dst, square, tier, "a = a * a", an, an);
+
+    bignum_assign(dst, a);
+    bignum_square_into(dst, dst);
+    expect(dst, square, tier, "a = a^2", an, an);
+
+    bignum_free(dst);
+    bignum_free(product);
+    bignum_free(square);
+    bignum_free(expected);
+    bignum_free(b);
+    bignum_free(a);
+}
+
+// Равные, близкие и несбалансированные длины вокруг каждой длины из sizes
+static void check_sizes(const char* tier, const size_t* sizes, size_t count, uint64_t* state) {
+    for (size_t i = 0; i < count; i++) {
+        size_t n = sizes[i];
+        check(tier, n, n, false, state);
+        check(tier, n + n / 2 + 1, n, false, state);
+        check(tier, 2 * n + 1, n, false, state);
+        check(tier, 5 * n + 3, n, false, state);
+        check(tier, n, n, true, state);
+    }
+}
+
+int main(void) {
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    BigNumMulThresholds defaults = bignum_get_mul_thresholds();
+
+    // Малые пороги: каждый уровень и его рекурсия работают на коротких числах
+    static const size_t small[] = { 1, 3, 4, 5, 8, 9, 10, 15, 16, 17, 31, 33, 64, 100, 257 };
+    size_t small_count = sizeof(small) / sizeof(small[0]);
+    static const struct {
+        const char* name;
+        BigNumMulThresholds thresholds;
+        size_t threads;
+    } tiers[] = {
+        { "karatsuba", { 4, SIZE_MAX, SIZE_MAX, SIZE_MAX }, 1 },
+        { "toom3", { 4, 9, SIZE_MAX, SIZE_MAX }, 1 },
+        { "ntt", { 4, 9, 16, SIZE_MAX }, 1 },
+        { "parallel ntt", { 4, 9, 16, 16 }, 4 },
+    };
+    for (size_t i = 0; i < sizeof(tiers) / sizeof(tiers[0]); i++) {
+        bignum_set_mul_thresholds(&tiers[i].thresholds);
+        bignum_set_threads(tiers[i].threads);
+        check_sizes(tiers[i].name, small, small_count, &state);
+    }
+
+    // Пороги по умолчанию: длины по обе стороны от каждого
+    bignum_set_mul_thresholds(&defaults);
+    bignum_set_threads(4);
+    const size_t edges[] = {
+        defaults.karatsuba - 1, defaults.karatsuba, defaults.karatsuba + 1,
+        defaults.toom3 - 1, defaults.toom3, defaults.toom3 + 1,
+        defaults.ntt - 1, defaults.ntt, defaults.parallel - 1, defaults.parallel,
+    };
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        check("default", edges[i], edges[i], false, &state);
+        check("default", 2 * edges[i] + 1, edges[i], false, &state);
+    }
+    bignum_set_threads(1);
+
+    if (failures) {
+        fprintf(stderr, "%d failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "bignum.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Целый корень r = isqrt(n): r^2 <= n < (r+1)^2 на случайных числах по обе
+// стороны от 64 бит (ниже корень считается в машинных словах), на точных
+// квадратах k^2 и на k^2 - 1, где приближение Ньютона ближе всего к ошибке
+
+static int failures = 0;
+
+static uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// Случайное число ровно из bits бит (bits >= 1)
+static BigNum* random_bits(size_t bits, uint64_t* state) {
+    size_t limbs = (bits + 31) / 32;
+    BigNum* num = bignum_create();
+    arraylist_resize(num->digits, limbs);
+    for (size_t i = 0; i < limbs; i++) {
+        num->digits->data[i] = (uint32_t)(xorshift64(state) >> 32);
+    }
+    unsigned top = (unsigned)((bits - 1) % 32);
+    uint32_t* high = &num->digits->data[limbs - 1];
+    *high = (*high & (uint32_t)((((uint64_t)1 << top) - 1))) | ((uint32_t)1 << top);
+    return num;
+}
+
+// r^2 <= n < (r+1)^2, а также тот же ответ у bignum_isqrt_into поверх n
+static BigNum* check(const char* name, const BigNum* n) {
+    BigNum* r = bignum_isqrt(n);
+    BigNum* dst = bignum_clone(n);
+    BigNum* one = bignum_from_int(1);
+    BigNum* low = r ? bignum_square(r) : NULL;
+    BigNum* next = r ? bignum_add(r, one) : NULL;
+    BigNum* high = next ? bignum_square(next) : NULL;
+
+    if (!high || !bignum_isqrt_into(dst, dst) || bignum_compare(dst, r) != 0 ||
+        bignum_compare(low, n) > 0 || bignum_compare(n, high) >= 0) {
+        fprintf(stderr, "FAIL: %s (%zu limbs)\n", name, arraylist_size(n->digits));
+        failures++;
+    }
+
+    bignum_free(high);
+    bignum_free(next);
+    bignum_free(low);
+    bignum_free(one);
+    bignum_free(dst);
+    return r;
+}
+
+static void check_exact(const char* name, const BigNum* n, const BigNum* expected) {
+    BigNum* r = check(name, n);
+    if (r && bignum_compare(r, expected) != 0) {
+        fprintf(stderr, "FAIL: %s (%zu limbs): wrong root\n", name, arraylist_size(n->digits));
+        failures++;
+    }
+    bignum_free(r);
+}
+
+// Случайное k из bits бит: корни из k, k^2 и k^2 - 1
+static void check_length(size_t bits, uint64_t* state) {
+    BigNum* one = bignum_from_int(1);
+    BigNum* k = random_bits(bits, state);
+    BigNum* square = bignum_square(k);
+    BigNum* below = bignum_subtract(square, one);
+    BigNum* k_minus_1 = bignum_subtract(k, one);
+
+    bignum_free(check("random", k));
+    check_exact("square", square, k);
+    check_exact("square - 1", below, k_minus_1);
+
+    bignum_free(k_minus_1);
+    bignum_free(below);
+    bignum_free(square);
+    bignum_free(k);
+    bignum_free(one);
+}
+
+int main(void) {
+    uint64_t state = 0xda3e39cb94b95bdbull;
+
+    // Малые значения целиком
+    for (int64_t v = 0; v <= 1000; v++) {
+        BigNum* n = bignum_from_int(v);
+        bignum_free(check("small", n));
+        bignum_free(n);
+    }
+
+    // Случайные числа: все длины до 300 бит, дальше выборочно до 20000 разрядов
+    for (size_t bits = 1; bits <= 300; bits++) {
+        for (int i = 0; i < 8; i++) {
+            check_length(bits, &state);
+        }
+    }
+    static const size_t long_bits[] = { 1000, 4095, 4096, 4097, 32 * 1000, 32 * 5000 + 7,
+                                        32 * 20000 };
+    for (size_t i = 0; i < sizeof(long_bits) / sizeof(long_bits[0]); i++) {
+        check_length(long_bits[i], &state);
+    }
+
+    // Отрицательное число корня не имеет
+    BigNum* negative = bignum_from_int(-4);
+    BigNum* root = bignum_isqrt(negative);
+    if (root) {
+        fprintf(stderr, "FAIL: isqrt(-4) succeeded\n");
+        failures++;
+    }
+    bignum_free(root);
+    bignum_free(negative);
+
+    if (failures) {
+        fprintf(stderr, "%d failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
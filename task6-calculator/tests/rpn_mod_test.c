@@ -0,0 +1,49 @@
+#include "rpn.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Регрессионные проверки модульного режима: показатель степени не приводится по модулю
+
+static int failures = 0;
+
+// expected == NULL — ожидается ошибка
+static void check(const char* expression, const char* modulus, const char* expected) {
+    BigNum* m = bignum_from_string(modulus);
+    RPNResult result = rpn_evaluate_mod(expression, m);
+    char* text = result.error == RPN_OK ? bignum_to_string(result.result) : NULL;
+
+    bool ok = expected ? text && strcmp(text, expected) == 0 : result.error != RPN_OK;
+    if (!ok) {
+        fprintf(stderr, "FAIL: '%s' mod %s: got %s, expected %s\n", expression, modulus,
+                text ? text : result.error_message, expected ? expected : "error");
+        failures++;
+    }
+
+    free(text);
+    rpn_result_free(&result);
+    bignum_free(m);
+}
+
+int main(void) {
+    // Показатель не меньше модуля
+    check("2 10 ^", "7", "2");
+    check("3 7 ^", "7", "3");
+    check("3 100 ^", "7", "4");
+    check("2 7 ^", "7", "2");
+    check("5 1000000007 ^", "1000000007", "5");
+    check("2 18446744073709551617 ^", "1000000007", "926123051");
+    // Чётный модуль (без Монтгомери) и показатель в 16-ричной записи
+    check("3 0x10 ^", "10", "1");
+    check("10 3 ^ 2 ^", "7", "1");
+
+    // Показатель — результат операции или отрицательное число
+    check("2 3 4 + ^", "7", NULL);
+    check("2 -1 ^", "7", NULL);
+
+    if (failures) {
+        fprintf(stderr, "%d failed\n", failures);
+        return 1;
+    }
+    return 0;
+}